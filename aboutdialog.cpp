@@ -4,6 +4,7 @@
 #include "settings.h"
 #include "logger.h"
 #include "licensedialog.h"
+#include "launchhistory.h"
 
 AboutDialog::AboutDialog(QWidget *parent) :
     QDialog(parent),
@@ -14,12 +15,35 @@ AboutDialog::AboutDialog(QWidget *parent) :
 
     ui->linkLabel->setOpenExternalLinks(true); // open link in external browser
 
+    showLaunchStats();
+
     connect(ui->closeButton, SIGNAL(clicked()), this, SLOT(close()));
     connect(ui->licenseButton, SIGNAL(clicked()), this, SLOT(showLicense()));
 
     Logger::logger()->append("AboutDialog", "About dialog opened\n");
 }
 
+void AboutDialog::showLaunchStats() {
+
+    QList<LaunchHistory::PhaseStats> stats = LaunchHistory::loadStats();
+    if (stats.isEmpty()) {
+        ui->statsLabel->hide();
+        return;
+    }
+
+    QString text = "<p align=\"center\">Время запуска игры, мс</p><table cellspacing=\"4\">"
+                   "<tr><th align=\"left\">Этап</th><th>p50</th><th>p95</th><th>Запусков</th></tr>";
+    foreach (LaunchHistory::PhaseStats phase, stats) {
+        text += "<tr><td>" + LaunchHistory::getPhaseTitle(phase.phase) + "</td>"
+                + "<td align=\"right\">" + QString::number(phase.p50) + "</td>"
+                + "<td align=\"right\">" + QString::number(phase.p95) + "</td>"
+                + "<td align=\"right\">" + QString::number(phase.count) + "</td></tr>";
+    }
+    text += "</table>";
+
+    ui->statsLabel->setText(text);
+}
+
 void AboutDialog::showLicense() {
     LicenseDialog* d = new LicenseDialog(this);
     d->exec();
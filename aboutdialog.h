@@ -17,6 +17,7 @@ public:
 
 private:
     Ui::AboutDialog *ui;
+    void showLaunchStats();
 private slots:
     void showLicense();
 };
@@ -0,0 +1,155 @@
+#include "authsession.h"
+
+#include "settings.h"
+#include "logger.h"
+#include "util.h"
+
+static QString getSessionFileName() {
+    return Settings::instance()->getBaseDir() + "/session.json";
+}
+
+// Answer to validate or refresh request
+enum Answer { Accepted, Rejected, Unsupported, Failed };
+
+// Only explicit answer with access token is successful and only JSON error is
+// a rejection. Anything else means the server does not implement the request,
+// so empty or generic page must not accept a stale token.
+static Answer readAnswer(Reply reply, QJsonObject* data) {
+
+    // Network problem, nothing is known about the server
+    if (!reply.isOK()) return Failed;
+
+    QJsonParseError error;
+    QJsonDocument json = QJsonDocument::fromJson(reply.reply(), &error);
+    if (error.error != QJsonParseError::NoError || !json.isObject()) return Unsupported;
+
+    *data = json.object();
+    if (!(*data)["error"].isNull()) return Rejected;
+    if ((*data)["accessToken"].toString().isEmpty()) return Unsupported;
+
+    return Accepted;
+}
+
+static QByteArray makeTokensPayload(const AuthSession::Session& session) {
+    QJsonObject payload;
+    payload["accessToken"] = session.accessToken;
+    payload["clientToken"] = session.clientToken;
+    return QJsonDocument(payload).toJson();
+}
+
+static QJsonObject readSessionFile() {
+
+    QFile sessionFile(getSessionFileName());
+    if (!sessionFile.open(QIODevice::ReadOnly)) return QJsonObject();
+
+    QJsonObject data = QJsonDocument::fromJson(sessionFile.readAll()).object();
+    sessionFile.close();
+    return data;
+}
+
+static void writeSessionFile(const QJsonObject& data) {
+
+    // Permissions are restricted before tokens are written
+    QFile sessionFile(getSessionFileName());
+    if (!sessionFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        Logger::logger()->append("AuthSession", "Error: can't save session: " + sessionFile.errorString() + "\n");
+        return;
+    }
+    sessionFile.setPermissions(QFile::ReadOwner | QFile::WriteOwner);
+    sessionFile.write(QJsonDocument(data).toJson(QJsonDocument::Compact));
+    sessionFile.close();
+}
+
+// Server without validate and refresh requests, remembered so later launches
+// go straight to password login
+static bool isUnsupported() {
+    return readSessionFile()["unsupported"].toBool();
+}
+
+static void markUnsupported() {
+    QJsonObject data;
+    data["unsupported"] = true;
+    writeSessionFile(data);
+}
+
+namespace AuthSession {
+
+bool load(QString login, Session* session) {
+
+    QJsonObject data = readSessionFile();
+
+    // Session of another player, or sessions are not supported
+    if (data["unsupported"].toBool() || data["login"].toString() != login) return false;
+
+    session->login = login;
+    session->accessToken = data["accessToken"].toString();
+    session->clientToken = data["clientToken"].toString();
+
+    return !session->accessToken.isEmpty() && !session->clientToken.isEmpty();
+}
+
+void save(const Session& session) {
+
+    // Tokens are useless then
+    if (isUnsupported()) return;
+
+    QJsonObject data;
+    data["login"] = session.login;
+    data["accessToken"] = session.accessToken;
+    data["clientToken"] = session.clientToken;
+    writeSessionFile(data);
+}
+
+// Tokens are removed, knowledge about the server is kept
+void clear() {
+    if (isUnsupported()) {
+        markUnsupported();
+    } else {
+        QFile::remove(getSessionFileName());
+    }
+}
+
+Reply authenticate(Session session, bool hasSession, QByteArray passwordPayload) {
+
+    Logger* logger = Logger::logger();
+
+    if (hasSession) {
+        QJsonObject data;
+        Answer answer = readAnswer(Util::makePost(Settings::validateUrl, makeTokensPayload(session)), &data);
+
+        if (answer == Accepted && data["accessToken"].toString() == session.accessToken) {
+            logger->append("AuthSession", "Saved session is valid\n");
+
+            QJsonObject reply;
+            reply["accessToken"] = session.accessToken;
+            reply["clientToken"] = session.clientToken;
+            return Reply(true, "", QJsonDocument(reply).toJson());
+        }
+
+        // Refresh is tried only for a token the server explicitly rejected
+        if (answer == Accepted || answer == Rejected) {
+            data = QJsonObject();
+            answer = readAnswer(Util::makePost(Settings::refreshUrl, makeTokensPayload(session)), &data);
+
+            if (answer == Accepted) {
+                logger->append("AuthSession", "Saved session is refreshed\n");
+
+                QJsonObject reply;
+                reply["accessToken"] = data["accessToken"].toString();
+                reply["clientToken"] = data["clientToken"].isString() ? data["clientToken"].toString() : session.clientToken;
+                return Reply(true, "", QJsonDocument(reply).toJson());
+            }
+        }
+
+        if (answer == Unsupported) {
+            logger->append("AuthSession", "Server doesn't support sessions, login with password from now on\n");
+            markUnsupported();
+        } else {
+            logger->append("AuthSession", "Saved session is rejected, login with password\n");
+        }
+    }
+
+    return Util::makePost(Settings::authUrl, passwordPayload);
+}
+
+}
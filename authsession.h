@@ -0,0 +1,33 @@
+#ifndef AUTHSESSION_H
+#define AUTHSESSION_H
+
+#include <QtCore>
+
+#include "reply.h"
+
+// Tokens of the last successful login, kept in session.json readable by
+// the owner only. Saved session is validated or refreshed on Play, so
+// password login is needed only when server rejects the session. If server
+// doesn't implement validate and refresh, it is remembered in session.json.
+namespace AuthSession {
+
+struct Session {
+    QString login;
+    QString accessToken;
+    QString clientToken;
+};
+
+// Returns false if there is no saved session for the login
+bool load(QString login, Session* session);
+void save(const Session& session);
+void clear();
+
+// Validates the session, refreshes it only if server rejected it with JSON
+// error, falls back to password login. Success is JSON with access token (the
+// same one for validation). Returns reply in format of the login reply.
+// Runs in worker thread.
+Reply authenticate(Session session, bool hasSession, QByteArray passwordPayload);
+
+}
+
+#endif // AUTHSESSION_H
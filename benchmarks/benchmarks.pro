@@ -0,0 +1,41 @@
+#-------------------------------------------------
+#
+# Benchmarks of index caches, not a part of the launcher build:
+#   qmake benchmarks.pro && make && ./benchmarks
+#
+#-------------------------------------------------
+
+QT       += core network concurrent testlib
+QT       -= gui
+
+TARGET = benchmarks
+TEMPLATE = app
+CONFIG += console testcase
+CONFIG -= app_bundle
+
+LIBS += -lquazip
+
+INCLUDEPATH += ..
+
+SOURCES += indexbenchmark.cpp \
+    ../indexcache.cpp \
+    ../filetree.cpp \
+    ../gameindex.cpp \
+    ../mavencoordinate.cpp \
+    ../fingerprintcache.cpp \
+    ../storewatcher.cpp \
+    ../settings.cpp \
+    ../logger.cpp \
+    ../util.cpp \
+    ../reply.cpp
+
+HEADERS += ../indexcache.h \
+    ../filetree.h \
+    ../gameindex.h \
+    ../mavencoordinate.h \
+    ../fingerprintcache.h \
+    ../storewatcher.h \
+    ../settings.h \
+    ../logger.h \
+    ../util.h \
+    ../reply.h
@@ -0,0 +1,186 @@
+#include <QtTest>
+
+#include "settings.h"
+#include "indexcache.h"
+#include "filetree.h"
+
+// Compares parsing of plain JSON indexes into the typed model with loading of
+// compiled cache, and comparison of installed and current files indexes
+class IndexBenchmark : public QObject
+{
+    Q_OBJECT
+
+private:
+    QTemporaryDir dir;
+    QString assetsFileName;
+    QByteArray assetsData;
+
+    GameIndex::FileIndex installedFiles;
+    GameIndex::FileIndex oneDirChangedFiles;
+    GameIndex::FileIndex allDirsChangedFiles;
+
+    QHash<QString, QString> installedTree;
+    QHash<QString, QString> oneDirChangedTree;
+    QHash<QString, QString> allDirsChangedTree;
+
+private slots:
+    void initTestCase();
+
+    void parseJson();
+    void parseCompiled();
+    void readCompiled();
+
+    void compareOneDirChanged();
+    void compareAllDirsChanged();
+    void compareAllEntries();
+    void makeTree();
+};
+
+// Assets index with 50k objects, like big modpacks have
+static QByteArray makeAssetsIndex(int count) {
+    QJsonObject objects;
+    for (int i = 0; i < count; i++) {
+        QByteArray hash = QCryptographicHash::hash(QByteArray::number(i), QCryptographicHash::Sha1).toHex();
+
+        QJsonObject object;
+        object["hash"] = QString(hash);
+        object["size"] = double(i * 37 % 100000);
+        objects["minecraft/sounds/dir" + QString::number(i % 500) + "/sound" + QString::number(i) + ".ogg"] = object;
+    }
+
+    QJsonObject index;
+    index["objects"] = objects;
+    return QJsonDocument(index).toJson();
+}
+
+static bool pathLess(const GameIndex::Entry& a, const GameIndex::Entry& b) {
+    return a.path < b.path;
+}
+
+// Files index with 100k entries in 1000 directories, changed ones get another hash.
+// Entries are sorted like in parsed data.json.
+static GameIndex::FileIndex makeFilesIndex(int count, int changedDirs) {
+    QVector<GameIndex::Entry> entries;
+    entries.reserve(count);
+
+    for (int i = 0; i < count; i++) {
+        int dir = i % 1000;
+
+        GameIndex::Entry entry;
+        entry.path = "mods/dir" + QString::number(dir) + "/file" + QString::number(i) + ".jar";
+        entry.hash = QCryptographicHash::hash(QByteArray::number(i) + (dir < changedDirs ? "x" : ""),
+                                              QCryptographicHash::Sha1).toHex();
+        entry.size = quint64(i);
+        entries.append(entry);
+    }
+    qSort(entries.begin(), entries.end(), pathLess);
+
+    GameIndex::FileIndex index;
+    index.reserve(count);
+    foreach (const GameIndex::Entry& entry, entries) index.append(entry);
+    return index;
+}
+
+void IndexBenchmark::initTestCase() {
+
+    // Keep launcher data and settings away from user's ones
+    QStandardPaths::setTestModeEnabled(true);
+    Settings::instance();
+
+    QVERIFY(dir.isValid());
+    assetsFileName = dir.path() + "/assets.json";
+    assetsData = makeAssetsIndex(50000);
+
+    QFile file(assetsFileName);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(assetsData);
+    file.close();
+
+    // Compile cache and check it gives the same index
+    GameIndex::AssetsIndex parsed = GameIndex::AssetsIndex::fromJson(QJsonDocument::fromJson(assetsData).object());
+    QCOMPARE(IndexCache::parseAssets(assetsFileName, assetsData).objects.size(), 50000);
+    QVERIFY(QFile::exists(assetsFileName + ".bin"));
+
+    GameIndex::AssetsIndex compiled = IndexCache::readAssets(assetsFileName);
+    QCOMPARE(compiled.objects.size(), parsed.objects.size());
+    for (int i = 0; i < parsed.objects.size(); i++) {
+        const GameIndex::Entry& entry = parsed.objects.getEntries().at(i);
+        const GameIndex::Entry* compiledEntry = compiled.objects.find(entry.path);
+        QVERIFY(compiledEntry != 0);
+        QCOMPARE(compiledEntry->hash, entry.hash);
+        QCOMPARE(compiledEntry->size, entry.size);
+    }
+
+    installedFiles = makeFilesIndex(100000, 0);
+    oneDirChangedFiles = makeFilesIndex(100000, 1);
+    allDirsChangedFiles = makeFilesIndex(100000, 1000);
+    QVERIFY(installedFiles.isSorted());
+
+    installedTree = FileTree::makeTree(installedFiles);
+    oneDirChangedTree = FileTree::makeTree(oneDirChangedFiles);
+    allDirsChangedTree = FileTree::makeTree(allDirsChangedFiles);
+}
+
+// Cold load: JSON tree is built and converted to the model
+void IndexBenchmark::parseJson() {
+    QBENCHMARK {
+        GameIndex::AssetsIndex index = GameIndex::AssetsIndex::fromJson(QJsonDocument::fromJson(assetsData).object());
+        QCOMPARE(index.objects.size(), 50000);
+    }
+}
+
+// Source is already read and hashed here
+void IndexBenchmark::parseCompiled() {
+    QBENCHMARK {
+        GameIndex::AssetsIndex index = IndexCache::parseAssets(assetsFileName, assetsData);
+        QCOMPARE(index.objects.size(), 50000);
+    }
+}
+
+// Source is not read at all if fingerprint is fresh
+void IndexBenchmark::readCompiled() {
+    QBENCHMARK {
+        GameIndex::AssetsIndex index = IndexCache::readAssets(assetsFileName);
+        QCOMPARE(index.objects.size(), 50000);
+    }
+}
+
+// Only files of the changed directory are visited
+void IndexBenchmark::compareOneDirChanged() {
+    QBENCHMARK {
+        FileTree::Diff diff = FileTree::compare(installedFiles, installedTree, oneDirChangedFiles, oneDirChangedTree);
+        QCOMPARE(diff.changed.size(), 100);
+        QCOMPARE(diff.unchangedDirs.size(), 999);
+        QVERIFY(diff.isUnchanged("mods/dir999/file999.jar"));
+    }
+}
+
+// Worst case: digests differ everywhere, every entry is compared
+void IndexBenchmark::compareAllDirsChanged() {
+    QBENCHMARK {
+        FileTree::Diff diff = FileTree::compare(installedFiles, installedTree, allDirsChangedFiles, allDirsChangedTree);
+        QCOMPARE(diff.changed.size(), 100000);
+    }
+}
+
+// data.json without digests
+void IndexBenchmark::compareAllEntries() {
+    QBENCHMARK {
+        FileTree::Diff diff = FileTree::compare(installedFiles, QHash<QString, QString>(),
+                                                oneDirChangedFiles, QHash<QString, QString>());
+        QCOMPARE(diff.changed.size(), 100);
+        QCOMPARE(diff.unchanged.size(), 99900);
+    }
+}
+
+// Done once by checkout, not by the updater
+void IndexBenchmark::makeTree() {
+    QBENCHMARK {
+        QHash<QString, QString> tree = FileTree::makeTree(oneDirChangedFiles);
+        QCOMPARE(tree.size(), 1002);
+    }
+}
+
+QTEST_GUILESS_MAIN(IndexBenchmark)
+
+#include "indexbenchmark.moc"
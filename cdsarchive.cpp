@@ -0,0 +1,137 @@
+#include "cdsarchive.h"
+#include "settings.h"
+#include "logger.h"
+#include "javaregistry.h"
+
+#include <QCryptographicHash>
+#include <QtConcurrent>
+
+CdsArchive::CdsArchive() {
+    mode = Disabled;
+}
+
+QString CdsArchive::getCacheDir() {
+    return Settings::instance()->getBaseDir() + "/cds/" + client;
+}
+
+void CdsArchive::prepare(QString java, QString client, QString version, QString classpath) {
+
+    Logger* logger = Logger::logger();
+
+    mode = Disabled;
+    this->client = client;
+    this->version = version;
+    javaId = "";
+    archiveName = "";
+
+    // Archive is bound to the exact JVM binary
+    QString javaPath = QFileInfo(java).isAbsolute() ? java : QStandardPaths::findExecutable(java);
+    QFileInfo javaInfo(QFileInfo(javaPath).canonicalFilePath());
+    if (javaPath.isEmpty() || !javaInfo.exists()) {
+        logger->append("CdsArchive", "Error: can't find java binary " + java + ", CDS disabled\n");
+        return;
+    }
+
+    // Dynamic archives need Java 13+, support is known from the runtime probe.
+    // Unknown binary is probed in background and gets archive on the next launch.
+    JavaRegistry* javaRegistry = JavaRegistry::instance();
+    JavaRegistry::Runtime runtime = javaRegistry->getCachedRuntime(java);
+    if (!runtime.probed) {
+        logger->append("CdsArchive", "Java " + java + " is not probed yet, CDS disabled\n");
+        QtConcurrent::run(javaRegistry, &JavaRegistry::getRuntime, java);
+        return;
+    }
+    if (!runtime.valid || !runtime.flags.contains("ArchiveClassesAtExit")) {
+        logger->append("CdsArchive", "Java " + java + " has no dynamic CDS, CDS disabled\n");
+        return;
+    }
+
+    QCryptographicHash key(QCryptographicHash::Sha1);
+    key.addData(javaInfo.filePath().toUtf8());
+    key.addData(QByteArray::number(javaInfo.size()));
+    key.addData(QByteArray::number(javaInfo.lastModified().toMSecsSinceEpoch()));
+    key.addData(version.toUtf8());
+    key.addData(classpath.toUtf8());
+
+    javaId = QString(QCryptographicHash::hash(javaInfo.filePath().toUtf8(), QCryptographicHash::Sha1).toHex().left(8));
+    archiveName = getCacheDir() + "/" + version + "-" + javaId + "-" + QString(key.result().toHex()) + ".jsa";
+
+    if (QFileInfo(archiveName).isFile()) {
+        mode = Use;
+    } else {
+        QDir().mkpath(getCacheDir());
+        QFile::remove(archiveName + ".part");
+        mode = Create;
+    }
+
+    logger->append("CdsArchive", "Archive " + archiveName + ", mode: " + getModeString() + "\n");
+}
+
+CdsArchive::Mode CdsArchive::getMode() { return mode; }
+
+QString CdsArchive::getModeString() {
+    switch (mode) {
+    case Use: return "use";
+    case Create: return "create";
+    default: return "disabled";
+    }
+}
+
+QStringList CdsArchive::getArguments() {
+
+    QStringList args;
+    if (mode == Disabled) return args;
+
+    if (mode == Use) {
+        args << "-XX:SharedArchiveFile=" + archiveName << "-Xshare:auto";
+    } else {
+        args << "-XX:ArchiveClassesAtExit=" + archiveName + ".part";
+    }
+
+    return args;
+}
+
+void CdsArchive::finish(bool success) {
+
+    Logger* logger = Logger::logger();
+
+    if (mode == Create) {
+        QString partName = archiveName + ".part";
+
+        // Archive is written on JVM exit, only clean exit gives a complete one
+        if (success && QFileInfo(partName).isFile()) {
+            QFile::remove(archiveName);
+            if (QFile::rename(partName, archiveName)) {
+                logger->append("CdsArchive", "Archive created: " + archiveName + "\n");
+                removeStale();
+            }
+        } else {
+            logger->append("CdsArchive", "Archive is not created\n");
+        }
+        QFile::remove(partName);
+
+    } else if (mode == Use && !success) {
+
+        // Will be recreated on the next launch
+        logger->append("CdsArchive", "Game failed with archive, dropping it\n");
+        QFile::remove(archiveName);
+    }
+
+    mode = Disabled;
+}
+
+void CdsArchive::removeStale() {
+
+    // Archives of the version for previous classpath or update of the same JVM
+    QDir cacheDir(getCacheDir());
+    QRegExp staleName(QRegExp::escape(version) + "-" + javaId + "-[0-9a-f]{40}\\.jsa");
+    foreach (QString name, cacheDir.entryList(QStringList() << "*.jsa", QDir::Files)) {
+        if (!staleName.exactMatch(name)) continue;
+
+        QString fileName = cacheDir.absoluteFilePath(name);
+        if (fileName == archiveName) continue;
+
+        QFile::remove(fileName);
+        Logger::logger()->append("CdsArchive", "Removed stale archive " + name + "\n");
+    }
+}
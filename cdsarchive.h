@@ -0,0 +1,40 @@
+#ifndef CDSARCHIVE_H
+#define CDSARCHIVE_H
+
+#include <QtCore>
+
+// Dynamic class data sharing archive of the game, stored in
+// <base>/cds/<client>/<version>-<jvm>-<key>.jsa, <jvm> is a hash of java path.
+// Key covers java binary and classpath, so archive is recreated after update
+// of the game or JVM, other JVMs keep their archives. Used only with
+// JVMs supporting dynamic archives according to JavaRegistry probe.
+class CdsArchive
+{
+public:
+    enum Mode { Disabled, Use, Create };
+
+    CdsArchive();
+
+    // Selects mode: use existing archive or dump a new one at exit
+    void prepare(QString java, QString client, QString version, QString classpath);
+
+    Mode getMode();
+    QString getModeString();
+    QStringList getArguments();
+
+    // Called after game exit: commits created archive or drops a suspicious one
+    void finish(bool success);
+
+private:
+    Mode mode;
+    QString client;
+    QString version;
+    QString javaId;
+    QString archiveName;
+
+    QString getCacheDir();
+    void removeStale();
+
+};
+
+#endif // CDSARCHIVE_H
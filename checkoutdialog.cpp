@@ -2,7 +2,14 @@
 #include "ui_checkoutdialog.h"
 
 #include "util.h"
-#include <QCryptographicHash>
+#include "installplan.h"
+#include "fingerprintcache.h"
+#include "filetree.h"
+#include "jsonwriter.h"
+#include "indexcache.h"
+
+#include <QtConcurrent>
+#include <QSaveFile>
 
 CheckoutDialog::CheckoutDialog(QWidget *parent) :
     QDialog(parent),
@@ -15,6 +22,7 @@ CheckoutDialog::CheckoutDialog(QWidget *parent) :
     ui->clientCombo->addItems(settings->getClientsNames());
 
     connect(ui->clientCombo, SIGNAL(currentIndexChanged(int)), this, SLOT(makeVersionList()));
+    connect(ui->versionCombo, SIGNAL(currentIndexChanged(int)), this, SLOT(loadMemoryHint()));
     makeVersionList();
 
     connect(ui->checkoutButton, SIGNAL(clicked()), this, SLOT(makeCheckout()));
@@ -24,16 +32,63 @@ CheckoutDialog::~CheckoutDialog() {
     delete ui;
 }
 
+// Files are hashed and written by batches, so hashes of all files are not kept at once
+static const int hashBatchSize = 1024;
+
+// Runs in worker threads, fingerprint cache is thread-safe
+static QString calculateHash(const QString& fname) {
+    return FingerprintCache::instance()->getHash(fname);
+}
+
+void CheckoutDialog::calculateHashes(QStringList fileList) {
+
+    FingerprintCache* cache = FingerprintCache::instance();
+
+    hashes.clear();
+
+    // Reuse hashes of files, not changed since previous checkout
+    QStringList changedList;
+    foreach (QString fname, fileList) {
+        QString hash = cache->getFreshHash(fname);
+        if (hash.isEmpty()) {
+            changedList << fname;
+        } else {
+            hashes[fname] = hash;
+        }
+    }
+
+    ui->log->appendPlainText("Расчёт контрольных сумм: изменено файлов "
+                             + QString::number(changedList.size()) + " из " + QString::number(fileList.size()));
+    logger->append("CheckoutDialog", "Hashing " + QString::number(changedList.size()) + " of "
+                   + QString::number(fileList.size()) + " files\n");
+
+    if (changedList.isEmpty()) return;
+
+    // Hash changed files in parallel, keep GUI alive
+    QFutureWatcher<QString> watcher;
+    QEventLoop loop;
+    connect(&watcher, SIGNAL(finished()), &loop, SLOT(quit()));
+    watcher.setFuture(QtConcurrent::mapped(changedList, calculateHash));
+    loop.exec();
+
+    QList<QString> results = watcher.future().results();
+    for (int i = 0; i < changedList.size(); i++) {
+        if (!results.at(i).isEmpty()) {
+            hashes[changedList.at(i)] = results.at(i);
+            rehashedCount++;
+        }
+    }
+}
+
 QPair<QString, int> CheckoutDialog::getHashAndSize(QString fname) {
 
-    QFile file(fname);
     QString hash;
     int size;
 
     ui->log->appendPlainText("Обработка файла: " + fname);
     logger->append("CheckoutDialog", "Checkout: " + fname + "\n");
 
-    if (!file.open(QIODevice::ReadOnly)) {
+    if (!hashes.contains(fname)) {
 
         hash = "cant_open_file";
         size = 0;
@@ -41,11 +96,8 @@ QPair<QString, int> CheckoutDialog::getHashAndSize(QString fname) {
 
     } else {
 
-        QString jarHash = QString(QCryptographicHash::hash(file.readAll(), QCryptographicHash::Sha1).toHex());
-        file.close();
-
-        hash = jarHash;
-        size = file.size();
+        hash = hashes[fname];
+        size = QFileInfo(fname).size();
     }
 
     QPair<QString, int> rvalue;
@@ -72,6 +124,7 @@ void CheckoutDialog::makeCheckout() {
 
     ui->clientCombo->setEnabled(false);
     ui->versionCombo->setEnabled(false);
+    ui->memorySpin->setEnabled(false);
     ui->checkoutButton->setEnabled(false);
 
     // Prepare strings
@@ -80,217 +133,176 @@ void CheckoutDialog::makeCheckout() {
                    + settings->getClientStrId(ui->clientCombo->currentIndex()) + "/"
                    + "versions/" + version + "/";
 
-    // Prepare JSON objects
-    QJsonObject dataObject;
-    QJsonObject main, libs, files;
-
-    // Setup main section
-    ui->log->appendPlainText("Секция: main");
-    logger->append("CheckoutDialog", "Section: main\n");
-
-    QPair<QString, int> hashAndSize = getHashAndSize(dataDir + version + ".jar");
-    main["hash"] = hashAndSize.first;
-    main["size"] = hashAndSize.second;
-
-    // Setup libs section
-    ui->log->appendPlainText("Секция: libs");
-    logger->append("CheckoutDialog", "Section: libs\n");
-
-    // Open index file (for libs enumerate)
-    QFile indexFile(dataDir + version + ".json");
-    if (!indexFile.open(QIODevice::ReadOnly)) {
-
-        ui->log->appendPlainText("ОШИБКА: Не удалось открыть индекс!");
-        logger->append("CheckoutDialog", "Error: Cant open index.json\n");
-        return;
-
-    } else {
-
-        QJsonDocument indexDoc;
-        QJsonArray libsIndex;
-        QJsonParseError error;
-
-        indexDoc = QJsonDocument::fromJson(indexFile.readAll(), &error);
-        indexFile.close();
-
-        if (error.error != QJsonParseError::NoError) {
+    // Enumerate libs for all platforms and architectures
+    InstallPlan plan;
+    if (!plan.resolve(settings->getClientStrId(ui->clientCombo->currentIndex()), version, InstallPlan::AllPlatforms)) {
 
+        if (plan.getError() == InstallPlan::IndexNotFound) {
+            ui->log->appendPlainText("ОШИБКА: Не удалось открыть индекс!");
+            logger->append("CheckoutDialog", "Error: Cant open index.json\n");
+        } else {
             ui->log->appendPlainText("ОШИБКА: Не удалось разобрать индекс!");
             logger->append("CheckoutDialog", "Error: Cant parse index.json\n");
-            return;
-
-        } else {
-
-            libsIndex = indexDoc.object()["libraries"].toArray();
-
-            foreach (QJsonValue lib, libsIndex) {
-
-                QString baseDir = settings->getLibsDir() + "/";
-                QString codedName = lib.toObject()["name"].toString();
-
-                QString domen, name, version;
-                domen =   codedName.split(':')[0];
-                name =    codedName.split(':')[1];
-                version = codedName.split(':')[2];
-
-                domen = domen.replace('.','/');
+        }
 
-                QString suffix = domen + "/" + name + "/" + version + "/" + name + "-" + version;
-                QString fname = baseDir + suffix;
+        ui->clientCombo->setEnabled(true);
+        ui->versionCombo->setEnabled(true);
+        ui->memorySpin->setEnabled(true);
+        ui->checkoutButton->setEnabled(true);
+        return;
+    }
 
-                if (!lib.toObject()["natives"].isNull()) {
+    QList<InstallPlan::Artifact> libList = plan.getArtifacts(InstallPlan::Library);
 
-                    // Get all os and architecture natives
-                    QStringList oslist;
-                    oslist << "linux" << "windows" << "osx";
+    // Enumerate additional files
+    QDir filesDir(dataDir + "files/");
+    QStringList fileList;
+    if (filesDir.exists()) {
+        Util::recursiveFlist(&fileList, "", dataDir + "files/");
+    }
 
-                    foreach (QString os, oslist) {
+    // Write checkout file: entries are streamed in sorted order as they are hashed,
+    // so generated data.json is deterministic. Typed files index is still kept,
+    // it makes directory digests and diff with installed prefix
+    rehashedCount = 0;
 
-                        // Check allow-disallow rules
-                        QJsonArray rules = lib.toObject()["rules"].toArray();
+    QSaveFile dataFile(dataDir + "data.json");
+    if (!dataFile.open(QIODevice::WriteOnly)) {
 
-                        bool allowLib = true;
-                        if (!rules.isEmpty()) {
+        ui->log->appendPlainText("ОШИБКА: Не удалось сохранить data-файл!");
+        logger->append("CheckoutDialog", "Error: can't save data.json: " + dataFile.errorString() + "\n");
 
-                            // Disallow libray if not in allow list
-                            allowLib = false;
+        ui->clientCombo->setEnabled(true);
+        ui->versionCombo->setEnabled(true);
+        ui->memorySpin->setEnabled(true);
+        ui->checkoutButton->setEnabled(true);
+        return;
+    }
 
-                            foreach (QJsonValue ruleValue, rules) {
-                                QJsonObject rule = ruleValue.toObject();
+    JsonWriter json(&dataFile);
+    json.beginObject();
 
-                                // Process allow variants (all or specified)
-                                if (rule["action"].toString() == "allow") {
-                                    if (rule["os"].toObject().isEmpty()) {
-                                        allowLib = true;
-                                    } else if (rule["os"].toObject()["name"].toString() == os) {
-                                        allowLib = true;
-                                    }
-                                }
+    // Setup files section
+    ui->log->appendPlainText("Секция: files");
+    logger->append("CheckoutDialog", "Section: files\n");
 
-                                // Make exclusions from allow-list
-                                if (rule["action"].toString() == "disallow") {
-                                    if (rule["os"].toObject()["name"].toString() == os) {
-                                        allowLib = false;
-                                    }
-                                }
-                            }
-                        }
+    GameIndex::FileIndex currentFiles;
+    currentFiles.reserve(fileList.size());
+    fileList.sort();
 
-                        // Go to next lib entry, if this are disallowed
-                        if (!allowLib) { continue; }
+    json.beginObject("files");
+    json.beginObject("index");
 
-                        if (!lib.toObject()["natives"].toObject()[os].isNull()) {
-                            QString natives = lib.toObject()["natives"].toObject()[os].toString();
-                            if (natives.contains("${arch}")) {
+    if (!filesDir.exists()) {
 
-                                QString n32 = natives;
-                                QString n64 = natives;
-                                QPair<QString, int> hashAndSize;
-                                QJsonObject libObj;
+        ui->log->appendPlainText("Ошибка: директория не сущетвувет: " + dataDir + "files/");
+        logger->append("CheckoutDialog", "Error: files directory not exists\n");
+        errList << QString("Директория модификаций не существует: " + dataDir + "files/");
 
-                                // 32-bit version
-                                n32.replace("${arch}", "32");
-                                hashAndSize = getHashAndSize(fname + "-" + n32 + ".jar");
-                                libObj["hash"] = hashAndSize.first;
-                                libObj["size"] = hashAndSize.second;
-                                libs[suffix + "-" + n32 + ".jar"] = libObj;
+    } else {
 
-                                // 64-bit version
-                                n64.replace("${arch}", "64");
-                                hashAndSize = getHashAndSize(fname + "-" + n64 + ".jar");
-                                libObj["hash"] = hashAndSize.first;
-                                libObj["size"] = hashAndSize.second;
-                                libs[suffix + "-" + n64 + ".jar"] = libObj;
+        for (int i = 0; i < fileList.size(); i++) {
 
-                            } else {
+            QString file = fileList.at(i);
 
-                                QPair<QString, int> hashAndSize = getHashAndSize(fname + "-" + natives + ".jar");
+            if (i % hashBatchSize == 0) {
+                QStringList hashList;
+                foreach (QString batchFile, fileList.mid(i, hashBatchSize)) {
+                    hashList << dataDir + "files/" + batchFile;
+                }
+                calculateHashes(hashList);
+            }
 
-                                QJsonObject libObj;
-                                libObj["hash"] = hashAndSize.first;
-                                libObj["size"] = hashAndSize.second;
-                                libs[suffix + "-" + natives + ".jar"] = libObj;
+            QPair<QString, int> hashAndSize = getHashAndSize(dataDir + "files/" + file);
 
-                            }
-                        }
-                    }
+            json.beginObject(file);
+            json.writeString("hash", hashAndSize.first);
+            json.writeNumber("size", hashAndSize.second);
+            json.endObject();
 
-                    QApplication::processEvents();
+            GameIndex::Entry entry;
+            entry.path = file;
+            entry.hash = hashAndSize.first;
+            entry.size = quint64(hashAndSize.second);
+            currentFiles.append(entry);
+        }
 
-                } else {
+    }
 
-                    // Do checksumm
-                    QPair<QString, int> hashAndSize = getHashAndSize(fname + ".jar");
+    json.endObject();
 
-                    QJsonObject libObj;
-                    libObj["hash"] = hashAndSize.first;
-                    libObj["size"] = hashAndSize.second;
-                    libs[suffix + ".jar"] = libObj;
+    // Make mutables list
+    QStringList mutableNames = ui->mutableList->toPlainText().split('\n', QString::SkipEmptyParts);
+    mutableNames.sort();
+    mutableNames.removeDuplicates();
 
-                }
+    json.beginArray("mutables");
+    foreach (QString mutableName, mutableNames) {
+        json.writeString(mutableName);
+    }
+    json.endArray();
 
-                QApplication::processEvents();
+    QHash<QString, QString> currentTree = FileTree::makeTree(currentFiles);
+    QStringList treeDirs = currentTree.keys();
+    treeDirs.sort();
 
-            }
-        }
+    json.beginObject("tree");
+    foreach (QString dir, treeDirs) {
+        json.writeString(dir, currentTree.value(dir));
     }
+    json.endObject();
 
+    json.endObject();
 
-    // Setup files section
-    ui->log->appendPlainText("Секция: files");
-    logger->append("CheckoutDialog", "Section: files\n");
-
-    QJsonArray mutables;
-    QJsonObject index;
+    // Setup libs section
+    ui->log->appendPlainText("Секция: libs");
+    logger->append("CheckoutDialog", "Section: libs\n");
 
-    // Make mutables list
-    QStringList mutableNames = ui->mutableList->toPlainText().split('\n');
-    foreach (QString mutableName, mutableNames) {
-        mutables.append(mutableName);
+    // Same library may be listed for several platforms
+    QMap<QString, QString> libPaths;
+    foreach (InstallPlan::Artifact lib, libList) {
+        libPaths.insert(lib.name, lib.path);
     }
 
-    // Make index
-    QDir filesDir(dataDir + "files/");
-    if (!filesDir.exists()) {
+    QStringList hashList = libPaths.values();
+    hashList << dataDir + version + ".jar";
+    calculateHashes(hashList);
 
-        ui->log->appendPlainText("Ошибка: директория не сущетвувет: " + dataDir + "files/");
-        logger->append("CheckoutDialog", "Error: files directory not exists\n");
-        errList << QString("Директория модификаций не существует: " + dataDir + "files/");
+    // Fingerprints of all batches are saved at once
+    if (rehashedCount > 0) FingerprintCache::instance()->save();
 
-    } else {
-
-        QStringList fileList;
-        Util::recursiveFlist(&fileList, "", dataDir + "files/");
+    json.beginObject("libs");
+    for (QMap<QString, QString>::const_iterator it = libPaths.constBegin(); it != libPaths.constEnd(); ++it) {
 
-        foreach (QString file, fileList) {
+        QPair<QString, int> hashAndSize = getHashAndSize(it.value());
 
-            QJsonObject fileObj;
-            QPair<QString, int> hashAndSize = getHashAndSize(dataDir + "files/" + file);
-            fileObj["hash"] = hashAndSize.first;
-            fileObj["size"] = hashAndSize.second;
+        json.beginObject(it.key());
+        json.writeString("hash", hashAndSize.first);
+        json.writeNumber("size", hashAndSize.second);
+        json.endObject();
+    }
+    json.endObject();
 
-            index[file] = fileObj;
-        }
+    // Setup main section
+    ui->log->appendPlainText("Секция: main");
+    logger->append("CheckoutDialog", "Section: main\n");
 
-    }
+    QPair<QString, int> hashAndSize = getHashAndSize(dataDir + version + ".jar");
 
-    files["mutables"] = mutables;
-    files["index"] = index;
+    json.beginObject("main");
+    json.writeString("hash", hashAndSize.first);
+    json.writeNumber("size", hashAndSize.second);
+    json.endObject();
 
-    // Write checkout file
-    dataObject["main"] = main;
-    dataObject["libs"] = libs;
-    dataObject["files"] = files;
+    // Recommended heap size, used by JVM profile of the launcher (keys are sorted)
+    if (ui->memorySpin->value() > 0) {
+        json.writeNumber("memory", ui->memorySpin->value());
+    }
 
-    QJsonDocument dataJson;
-    dataJson.setObject(dataObject);
+    json.endObject();
 
-    QFile dataFile(dataDir + "data.json");
-    if (!dataFile.open(QIODevice::WriteOnly)) {
+    if (!json.finish() || !dataFile.commit()) {
         errList << QString("Не удалось сохранить data-файл!");
-    } else {
-        dataFile.write(dataJson.toJson());
-        dataFile.close();
     }
 
     // Setup client-side prefix (for build testing)
@@ -301,6 +313,9 @@ void CheckoutDialog::makeCheckout() {
                    + settings->getClientStrId(ui->clientCombo->currentIndex()) + "/"
                    + "prefixes/" + version + "/";
 
+    QStringList changedFiles;
+    bool prefixInstalled = false;
+
     QFile installedDataFile(prefixDir + "installed_data.json");
     if (!installedDataFile.open(QIODevice::ReadOnly)) {
 
@@ -310,13 +325,12 @@ void CheckoutDialog::makeCheckout() {
 
     } else {
 
-        QJsonDocument installedDoc;
-        QJsonParseError error;
-
-        installedDoc = QJsonDocument::fromJson(installedDataFile.readAll(), &error);
+        QString error;
+        GameIndex::DataIndex installedIndex = IndexCache::parseData(dataDir + "installed_data.json",
+                                                                    installedDataFile.readAll(), &error);
         installedDataFile.close();
 
-        if (error.error != QJsonParseError::NoError) {
+        if (!error.isEmpty()) {
 
             ui->log->appendPlainText("Ошибка: невозможно разобрать installed_data.json! Префикс повреждён!");
             logger->append("CheckoutDialog", "Error: can't parse installed_data.json! Broken prefix!\n");
@@ -326,17 +340,22 @@ void CheckoutDialog::makeCheckout() {
         } else {
 
             // Remove old files, that not exists in new data.json
-            QStringList oldFileList = installedDoc.object()["files"].toObject()["index"].toObject().keys();
-            QStringList newFileList = index.keys();
+            FileTree::Diff diff = FileTree::compare(installedIndex.files, installedIndex.filesTree,
+                                                    currentFiles, currentTree);
 
-            foreach (QString file, oldFileList) {
-                if (newFileList.indexOf(file) == -1) {
+            changedFiles = (diff.added + diff.changed).toList();
+            changedFiles.sort();
+            prefixInstalled = true;
 
-                    ui->log->appendPlainText("Удаление файла: " + file);
-                    logger->append("CheckoutDialog", "Removing file: " + prefixDir + file + "\n");
-                    QFile::remove(prefixDir + file);
+            QStringList removedFiles = diff.removed.toList();
+            removedFiles.sort();
+
+            foreach (QString file, removedFiles) {
+
+                ui->log->appendPlainText("Удаление файла: " + file);
+                logger->append("CheckoutDialog", "Removing file: " + prefixDir + file + "\n");
+                QFile::remove(prefixDir + file);
 
-                }
             }
         }
     }
@@ -354,8 +373,10 @@ void CheckoutDialog::makeCheckout() {
     }
     QFile::copy(dataDir + "data.json", prefixDir + "installed_data.json");
 
-    // Copy files
-    foreach (QString fname, index.keys()) {
+    // Copy files, changed since previous installation only
+    if (!prefixInstalled) changedFiles = fileList;
+
+    foreach (QString fname, changedFiles) {
         ui->log->appendPlainText("Копирование: " + fname);
         logger->append("CheckoutDialog", "Copy: " + fname);
 
@@ -370,8 +391,9 @@ void CheckoutDialog::makeCheckout() {
         QFile::copy(dataDir + "files/" + fname, prefixDir + fname);
     }
 
-    ui->log->appendPlainText("Вычисление контрольных сумм завершено!");
-    logger->append("CheckoutDialog", "Checkout completed!");
+    ui->log->appendPlainText("Вычисление контрольных сумм завершено! Пересчитано файлов: "
+                             + QString::number(rehashedCount));
+    logger->append("CheckoutDialog", "Checkout completed, rehashed " + QString::number(rehashedCount) + " files\n");
 
     // Explode error list
     foreach (QString errStr, errList) {
@@ -380,6 +402,7 @@ void CheckoutDialog::makeCheckout() {
 
     ui->clientCombo->setEnabled(true);
     ui->versionCombo->setEnabled(true);
+    ui->memorySpin->setEnabled(true);
     ui->checkoutButton->setEnabled(true);
 
 }
@@ -399,3 +422,18 @@ void CheckoutDialog::makeVersionList() {
         logger->append("CheckoutDialog", "WARN: Empty client list!\n");
     }
 }
+
+// Keeps memory hint of the existing data.json
+void CheckoutDialog::loadMemoryHint() {
+
+    ui->memorySpin->setValue(0);
+    if (ui->versionCombo->count() < 1) return;
+
+    QString version = ui->versionCombo->currentText();
+    QString dataFileName = settings->getBaseDir() + "/client_"
+                   + settings->getClientStrId(ui->clientCombo->currentIndex()) + "/"
+                   + "versions/" + version + "/data.json";
+
+    GameIndex::DataIndex data = IndexCache::readData(dataFileName);
+    ui->memorySpin->setValue(data.memory);
+}
@@ -24,11 +24,16 @@ private:
 
     QStringList errList;
 
+    QHash<QString, QString> hashes;
+    int rehashedCount;
+
+    void calculateHashes(QStringList fileList);
     QPair<QString, int> getHashAndSize(QString fname);
 
 private slots:
     void makeCheckout();
     void makeVersionList();
+    void loadMemoryHint();
 };
 
 #endif // CHECKOUTDIALOG_H
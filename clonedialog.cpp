@@ -4,6 +4,7 @@
 #include <QStringList>
 
 #include "util.h"
+#include "versionscatalog.h"
 
 CloneDialog::CloneDialog(QWidget *parent) :
     QDialog(parent),
@@ -141,6 +142,9 @@ void CloneDialog::makeClone() {
                     versionFile.write(versionJson.toJson());
 
                     versionFile.close();
+
+                    VersionsCatalog::update(settings->getClientStrId(ui->clientCombo->currentIndex()),
+                                            ui->versionEdit->text());
                 } else {
                     ui->log->appendPlainText("Ошибка: не удалось записать файл: " + ui->versionEdit->text() + ".json");
                     logger->append("CloneDialog", "Error: can't write file: "  + ui->versionEdit->text() + ".json\n");
@@ -3,6 +3,8 @@
 
 #include <QFileDialog>
 #include "util.h"
+#include "gameindex.h"
+#include "indexcache.h"
 
 ExportDialog::ExportDialog(QWidget *parent) :
     QDialog(parent),
@@ -117,9 +119,10 @@ void ExportDialog::makeExport() {
     logger->append("ExportDialog", "Section: assets\n");
 
     QString ver = ui->versionCombo->currentText();
-    QFile versionFile(settings->getBaseDir() + "/client_"
-                      + settings->getClientStrId(ui->clientCombo->currentIndex())
-                      + "/versions/" + ver + "/" + ver + ".json");
+    QString versionDir = settings->getBaseDir() + "/client_"
+            + settings->getClientStrId(ui->clientCombo->currentIndex()) + "/versions/" + ver + "/";
+
+    QFile versionFile(versionDir + ver + ".json");
 
     if (!versionFile.open(QIODevice::ReadOnly)) {
 
@@ -128,18 +131,17 @@ void ExportDialog::makeExport() {
 
     } else {
 
-        QJsonDocument versionJDoc;
-        QJsonParseError error;
-
-        versionJDoc = QJsonDocument::fromJson(versionFile.readAll(), &error);
-        if (error.error != QJsonParseError::NoError) {
+        QString error;
+        GameIndex::VersionIndex versionIndex = IndexCache::parseVersion(versionFile.fileName(),
+                                                                        versionFile.readAll(), &error);
+        if (!error.isEmpty()) {
 
             ui->log->appendPlainText("Ошибка: не удалось разобрать индекс <ver>.json!");
             logger->append("ExportDialog", "Error: cant parse version json!\n");
 
         } else {
 
-            QString assetsver = versionJDoc.object()["assets"].toString();
+            QString assetsver = versionIndex.assets;
             QFile assetsIndex(settings->getBaseDir() + "/assets/indexes/" + assetsver + ".json");
 
             if (!assetsIndex.open(QIODevice::ReadOnly)) {
@@ -149,8 +151,9 @@ void ExportDialog::makeExport() {
 
             } else {
 
-                QJsonDocument assetsDoc = QJsonDocument::fromJson(assetsIndex.readAll(), &error);
-                if (error.error != QJsonParseError::NoError) {
+                GameIndex::AssetsIndex assets = IndexCache::parseAssets(assetsIndex.fileName(),
+                                                                        assetsIndex.readAll(), &error);
+                if (!error.isEmpty()) {
 
                     ui->log->appendPlainText("Ошибка: не удалось разобрать индекс ассетов!");
                     logger->append("ExportDialog", "Error: cant parse assets index json!\n");
@@ -162,10 +165,9 @@ void ExportDialog::makeExport() {
                              ui->dirEdit->text()    + "/assets/indexes/" + assetsver + ".json");
 
                     // Copy assets
-                    QJsonObject assets = assetsDoc.object()["objects"].toObject();
-                    foreach (QString key, assets.keys()) {
+                    foreach (const GameIndex::Entry& asset, assets.objects.getEntries()) {
 
-                        QString hash = assets[key].toObject()["hash"].toString();
+                        QString hash = asset.hash;
                         QString hashDir = hash.mid(0, 2);
 
                         copyFile(settings->getBaseDir() + "/assets/objects/" + hashDir + "/" + hash,
@@ -185,9 +187,7 @@ void ExportDialog::makeExport() {
     ui->log->appendPlainText(" >> Экспорт: библиотеки");
     logger->append("ExportDialog", "Section: libraries\n");
 
-    QFile dataFile(settings->getBaseDir() + "/client_"
-                   + settings->getClientStrId(ui->clientCombo->currentIndex())
-                   + "/versions/" + ver + "/" + "data.json");
+    QFile dataFile(versionDir + "data.json");
 
     if (!dataFile.open(QIODevice::ReadOnly)) {
 
@@ -196,19 +196,17 @@ void ExportDialog::makeExport() {
 
     } else {
 
-        QJsonDocument dataDoc;
-        QJsonParseError error;
-
-        dataDoc = QJsonDocument::fromJson(dataFile.readAll(), &error);
-        if (error.error != QJsonParseError::NoError) {
+        QString error;
+        GameIndex::DataIndex dataIndex = IndexCache::parseData(dataFile.fileName(), dataFile.readAll(), &error);
+        if (!error.isEmpty()) {
 
             ui->log->appendPlainText("Ошибка: не удалось разобрать data.json!");
             logger->append("ExportDialog", "Error: cant parse data.json!\n");
 
         } else {
 
-            QJsonObject libs = dataDoc.object()["libs"].toObject();
-            foreach (QString suffix, libs.keys()) {
+            foreach (const GameIndex::Entry& lib, dataIndex.libs.getEntries()) {
+                QString suffix = lib.path;
                 copyFile(settings->getLibsDir() + "/" + suffix,
                          ui->dirEdit->text() + "/libraries/" + suffix);
 
@@ -217,7 +215,7 @@ void ExportDialog::makeExport() {
                 if (!shaFile.exists()) {
                     if (shaFile.open(QIODevice::WriteOnly)) {
                         QByteArray hashData;
-                        hashData.append(libs[suffix].toObject()["hash"].toString());
+                        hashData.append(lib.hash);
                         shaFile.write(hashData);
                         shaFile.close();
                     }
@@ -230,8 +228,8 @@ void ExportDialog::makeExport() {
             ui->log->appendPlainText(" >> Экспорт: дополнительные файлы");
             logger->append("ExportDialog", "Section: additional files\n");
 
-            QJsonObject files = dataDoc.object()["files"].toObject()["index"].toObject();
-            foreach (QString suffix, files.keys()) {
+            foreach (const GameIndex::Entry& file, dataIndex.files.getEntries()) {
+                QString suffix = file.path;
                 copyFile(settings->getBaseDir() + "/client_"
                          + settings->getClientStrId(ui->clientCombo->currentIndex())
                          + "/versions/" + ver + "/files/" + suffix,
@@ -241,10 +239,9 @@ void ExportDialog::makeExport() {
                 QApplication::processEvents();
             }
 
-            QJsonArray mutables = dataDoc.object()["files"].toObject()["mutables"].toArray();
             QByteArray mutablesList;
-            foreach (QJsonValue file, mutables) {
-                mutablesList.append(file.toString() + '\n');
+            foreach (QString file, dataIndex.mutables) {
+                mutablesList.append(file + '\n');
             }
 
             ui->log->appendPlainText("Генерация mutables.list");
@@ -4,6 +4,7 @@
 #include "settings.h"
 #include "reply.h"
 #include "util.h"
+#include "javaregistry.h"
 
 FeedbackDialog::FeedbackDialog(QWidget *parent) :
     QDialog(parent),
@@ -69,7 +70,12 @@ void FeedbackDialog::sendFeedback() {
     log.append("## ============================= ##\n");
     log.append("\n");
 
-    log.append(Util::getCommandOutput("java", QStringList() << "-version"));
+    // Runtimes are probed by registry in background, only its cache is read here
+    JavaRegistry* javaRegistry = JavaRegistry::instance();
+    log.append(" >> Java in PATH: " + JavaRegistry::describe(javaRegistry->getCachedRuntime("java")) + "\n");
+    foreach (JavaRegistry::Runtime runtime, javaRegistry->getCachedRuntimes()) {
+        log.append(" >> Found Java: " + JavaRegistry::describe(runtime) + "\n");
+    }
     log.append("\n");
 
     // Show custom java -version if exists
@@ -80,7 +86,7 @@ void FeedbackDialog::sendFeedback() {
 
         if (settings->loadClientJavaState()) {
             log.append(" >> Client \"" + settings->getClientStrId(clientList.indexOf(client)) + "\" has custom java:\n");
-            log.append(Util::getCommandOutput(settings->loadClientJava(), QStringList() << "-version"));
+            log.append(JavaRegistry::describe(javaRegistry->getCachedRuntime(settings->loadClientJava())) + "\n");
             log.append("\n");
         }
 
@@ -93,11 +99,15 @@ void FeedbackDialog::sendFeedback() {
     log.append("## ============================= ##\n");
     log.append("\n");
 
+    // Game output is kept in separate client logs
     QString logsPrefix = settings->getBaseDir() + "/";
-    for (int i = 0; i < 3; i++) {
-        log.append(" >> Log file \"launcher." + QString::number(i) + ".log\":\n");
-        log.append(Util::getFileContetnts(logsPrefix + "launcher." + QString::number(i) + ".log"));
-        log.append("\n");
+    foreach (QString logName, QStringList() << "launcher" << "client") {
+        for (int i = 0; i < 3; i++) {
+            QString fileName = logName + "." + QString::number(i) + ".log";
+            log.append(" >> Log file \"" + fileName + "\":\n");
+            log.append(Util::getFileContetnts(logsPrefix + fileName));
+            log.append("\n");
+        }
     }
 
     // Gzip and base-64 encode log
@@ -1,6 +1,7 @@
 #include "fetchdialog.h"
 #include "ui_fetchdialog.h"
 #include "util.h"
+#include "installplan.h"
 
 FetchDialog::FetchDialog(QWidget *parent) :
     QDialog(parent),
@@ -55,186 +56,74 @@ void FetchDialog::makeFetch() {
     errList.clear();
     errList << "-----" << "Список ошибок возникших при полной загрузке файлов:";
 
-    QString indexName = settings->getBaseDir()
-                      + "/client_"
-                      + settings->getClientStrId(ui->clientCombo->currentIndex())
-                      + "/versions/" + ui->versionCombo->currentText() + "/"
-                      + ui->versionCombo->currentText() + ".json";
+    QString client = settings->getClientStrId(ui->clientCombo->currentIndex());
+    QString version = ui->versionCombo->currentText();
 
-    QFile indexFile(indexName);
-    if (indexFile.open(QIODevice::ReadOnly)) {
+    // Resolve libraries for all platforms and architectures
+    InstallPlan plan;
+    if (plan.resolve(client, version, InstallPlan::AllPlatforms)) {
 
-        QJsonParseError error;
-        QJsonDocument indexJDoc = QJsonDocument::fromJson(indexFile.readAll(), &error);
+        // Fetch all libraries
+        ui->log->appendPlainText("Загрузка библиотек... ");
+        logger->append("FetchDialog", "Fetching libs... \n");
 
-        if (error.error == QJsonParseError::NoError) {
-            QJsonObject index = indexJDoc.object();
-            QJsonArray libs = index["libraries"].toArray();
+        foreach (InstallPlan::Artifact lib, plan.getArtifacts(InstallPlan::Library)) {
 
-            // Fetch all libraries
-            ui->log->appendPlainText("Загрузка библиотек... ");
-            logger->append("FetchDialog", "Fetching libs... \n");
+            QApplication::processEvents();
 
-            foreach (QJsonValue lib, libs) {
+            QString baseUrl = "https://libraries.minecraft.net/";
+            if (!lib.repository.isEmpty()) baseUrl = lib.repository;
 
-                QApplication::processEvents();
-
-                QString baseDir = settings->getLibsDir() + "/";
-                QString baseUrl = "https://libraries.minecraft.net/";
-                QString codedName = lib.toObject()["name"].toString();
-
-                QString domen, name, version;
-                domen =   codedName.split(':')[0];
-                name =    codedName.split(':')[1];
-                version = codedName.split(':')[2];
-
-                domen = domen.replace('.','/');
-
-                if (!lib.toObject()["url"].isNull())
-                    baseUrl = lib.toObject()["url"].toString();
-
-                // naming basename / domen / name / version / name-version [ -natives [-arch]] ".jar"
-
-                QString suffix = domen + "/" + name + "/" + version + "/" + name + "-" + version;
-                QString url = baseUrl + suffix;
-                QString fname = baseDir + suffix;
-
-                if (!lib.toObject()["natives"].isNull()) {
-
-                    // Get all os and architecture natives
-                    QStringList oslist;
-                    oslist << "linux" << "windows" << "osx";
-
-                    foreach (QString os, oslist) {
-
-                        QApplication::processEvents();
-
-                        // Check allow-disallow rules
-                        QJsonArray rules = lib.toObject()["rules"].toArray();
-
-                        bool allowLib = true;
-                        if (!rules.isEmpty()) {
-
-                            // Disallow libray if not in allow list
-                            allowLib = false;
-
-                            foreach (QJsonValue ruleValue, rules) {
-                                QJsonObject rule = ruleValue.toObject();
-
-                                // Process allow variants (all or specified)
-                                if (rule["action"].toString() == "allow") {
-                                    if (rule["os"].toObject().isEmpty()) {
-                                        allowLib = true;
-                                    } else if (rule["os"].toObject()["name"].toString() == os) {
-                                        allowLib = true;
-                                    }
-                                }
-
-                                // Make exclusions from allow-list
-                                if (rule["action"].toString() == "disallow") {
-                                    if (rule["os"].toObject()["name"].toString() == os) {
-                                        allowLib = false;
-                                    }
-                                }
-                            }
-                        }
+            downloadFile(baseUrl + lib.name, lib.path);
+        }
 
-                        // Go to next lib entry, if this are disallowed
-                        if (!allowLib) { continue; }
+        // Fetch all assets
+        ui->log->appendPlainText("Загрузка ресурсов... ");
+        logger->append("FetchDialog", "Fetching resources... \n");
 
-                        if (!lib.toObject()["natives"].toObject()[os].isNull()) {
-                            QString natives = lib.toObject()["natives"].toObject()[os].toString();
-                            if (natives.contains("${arch}")) {
+        QString assetsDir = settings->getAssetsDir();
+        QString assetsVer = plan.getAssetsId();
 
-                                QString n32 = natives;
-                                QString n64 = natives;
+        if (assetsVer.isEmpty()) {
 
-                                // 32-bit version
-                                n32.replace("${arch}", "32");
-                                downloadFile(url + "-" + n32 + ".jar",
-                                           fname + "-" + n32 + ".jar");
-                                // 64-bit version
-                                n64.replace("${arch}", "64");
-                                downloadFile(url + "-" + n64 + ".jar",
-                                           fname + "-" + n64 + ".jar");
-                            } else {
-                                downloadFile(url + "-" + natives + ".jar",
-                                           fname + "-" + natives + ".jar");
-                            }
-                        }
+            ui->log->appendPlainText("Ошибка: не указан файл ресурсов (assets)");
+            logger->append("FetchDialog", "Error assets id not found in version.jar \n");
 
-                    }
+        } else {
 
-                } else {
-                    downloadFile(url + ".jar", fname + ".jar");
-                }
-            }
+            Util::downloadFile("https://s3.amazonaws.com/Minecraft.Download/indexes/" + assetsVer + ".json",
+                                                 assetsDir + "/indexes/" + assetsVer + ".json");
 
-            // Fetch all assets
-            ui->log->appendPlainText("Загрузка ресурсов... ");
-            logger->append("FetchDialog", "Fetching resources... \n");
+            // Assets index may be changed, so plan are resolved again
+            if (!plan.resolve(client, version, InstallPlan::AllPlatforms)) {
 
-            QString assetsDir = settings->getAssetsDir();
-            QString assetsVer = index["assets"].toString();
+                ui->log->appendPlainText("Ошибка: " + plan.getErrorString());
+                logger->append("FetchDialog", "Error: " + plan.getErrorString() + "\n");
 
-            if (assetsVer.isEmpty()) {
+            } else if (!plan.hasAssetsIndex()) {
 
-                ui->log->appendPlainText("Ошибка: не указан файл ресурсов (assets)");
-                logger->append("FetchDialog", "Error assets id not found in version.jar \n");
+                ui->log->appendPlainText("Ошибка: отсутствует " + assetsVer + ".json");
+                logger->append("FetchDialog", "Error: no file: " + assetsDir + "/indexes/" + assetsVer + ".json\n");
 
             } else {
 
-                Util::downloadFile("https://s3.amazonaws.com/Minecraft.Download/indexes/" + assetsVer + ".json",
-                                                     assetsDir + "/indexes/" + assetsVer + ".json");
-                QFile assetsFile(assetsDir + "/indexes/" + assetsVer + ".json");
-
-                if (assetsFile.exists()) {
-                    if (assetsFile.open(QIODevice::ReadOnly)) {
-
-                        QJsonParseError error;
-                        QJsonDocument assetsDoc = QJsonDocument::fromJson(assetsFile.readAll(), &error);
-                        assetsFile.close();
-
-                        if (error.error == QJsonParseError::NoError) {
-
-                            QJsonObject assetsObjects = assetsDoc.object()["objects"].toObject();
-                            QStringList keys = assetsObjects.keys();
+                foreach (InstallPlan::Artifact asset, plan.getArtifacts(InstallPlan::Asset)) {
 
-                            foreach (QString key, keys) {
+                    QApplication::processEvents();
 
-                                QApplication::processEvents();
-
-                                QString hash = assetsObjects[key].toObject()["hash"].toString();
-                                QString objectsUrl = "http://resources.download.minecraft.net/" + hash.mid(0, 2) + "/" + hash;
-                                QString objectsDir = settings->getAssetsDir() + "/objects/" + hash.mid(0, 2) + "/" + hash;
-
-                                downloadFile(objectsUrl, objectsDir);
-                            }
-
-                        } else {
-                            ui->log->appendPlainText("Ошибка: не удалось разобрать JSON файл " + assetsFile.fileName());
-                            logger->append("FetchDialog", "Error: can't parse JSON file " + assetsFile.fileName() + "\n");
-                        }
-
-                    } else {
-                        ui->log->appendPlainText("Ошибка: не удалось открыть файл " + assetsFile.fileName());
-                        logger->append("FetchDialog", "Error: can't open file " + assetsFile.fileName() + "\n");
-                    }
-
-                } else {
-                    ui->log->appendPlainText("Ошибка: отсутствует " + assetsVer + ".json");
-                    logger->append("FetchDialog", "Error: no file: " + assetsDir + "/indexes/" + assetsVer + ".json\n");
+                    QString objectsUrl = "http://resources.download.minecraft.net/" + asset.hash.mid(0, 2) + "/" + asset.hash;
+                    downloadFile(objectsUrl, asset.path);
                 }
             }
-
-        } else {
-            ui->log->appendPlainText("Ошибка: не удалось разобрать JSON файл " + indexName);
-            logger->append("FetchDialog", "Error: can't parse JSON file " + indexName + "\n");
         }
 
+    } else if (plan.getError() == InstallPlan::IndexNotFound) {
+        ui->log->appendPlainText("Ошибка: не удалось открыть файл " + version + ".json");
+        logger->append("FetchDialog", "Error: " + plan.getErrorString() + "\n");
+
     } else {
-        ui->log->appendPlainText("Ошибка: не удалось открыть файл " + indexName);
-        logger->append("FetchDialog", "Error: can't open file " + indexName + "\n");
+        ui->log->appendPlainText("Ошибка: не удалось разобрать JSON файл " + version + ".json");
+        logger->append("FetchDialog", "Error: " + plan.getErrorString() + "\n");
     }
 
     // Explode error list
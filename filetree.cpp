@@ -0,0 +1,175 @@
+#include "filetree.h"
+
+#include <QCryptographicHash>
+
+#include <algorithm>
+
+static QString parentDir(const QString& path) {
+    int pos = path.lastIndexOf('/');
+    return (pos == -1) ? QString("") : path.left(pos);
+}
+
+static QString baseName(const QString& path) {
+    return path.mid(path.lastIndexOf('/') + 1);
+}
+
+// Children are always longer than their parents
+static bool deeperFirst(const QString& a, const QString& b) {
+    return a.length() > b.length();
+}
+
+static bool isSame(const GameIndex::Entry& a, const GameIndex::Entry& b) {
+    return a.hash == b.hash && a.size == b.size;
+}
+
+static bool pathLess(const GameIndex::Entry& entry, const QString& path) {
+    return entry.path < path;
+}
+
+// Entries of a subtree are contiguous in sorted index: "dir/" <= path < "dir0"
+static int skipSubtree(const QVector<GameIndex::Entry>& entries, int from, const QString& dir) {
+    QString end = dir + QChar('/' + 1);
+    return int(std::lower_bound(entries.constBegin() + from, entries.constEnd(), end, pathLess)
+               - entries.constBegin());
+}
+
+// Top-most parent directory with the same digest in both trees, or null string
+static QString findEqualDir(const QString& path, const QHash<QString, QString>& oldTree,
+                            const QHash<QString, QString>& newTree) {
+
+    for (int pos = path.indexOf('/'); pos != -1; pos = path.indexOf('/', pos + 1)) {
+        QString dir = path.left(pos);
+
+        QHash<QString, QString>::const_iterator it = oldTree.constFind(dir);
+        if (it != oldTree.constEnd() && *it == newTree.value(dir)) return dir;
+    }
+
+    return QString();
+}
+
+bool FileTree::Diff::isUnchanged(const QString& path) const {
+
+    if (unchanged.contains(path) || unchangedDirs.contains("")) return true;
+
+    for (int pos = path.indexOf('/'); pos != -1; pos = path.indexOf('/', pos + 1)) {
+        if (unchangedDirs.contains(path.left(pos))) return true;
+    }
+
+    return false;
+}
+
+QHash<QString, QString> FileTree::makeTree(const GameIndex::FileIndex& index) {
+
+    QHash<QString, QStringList> lines;
+    QSet<QString> dirs;
+    dirs.insert("");
+
+    foreach (const GameIndex::Entry& entry, index.getEntries()) {
+        QString dir = parentDir(entry.path);
+        lines[dir].append("f\t" + baseName(entry.path) + "\t" + entry.hash
+                + "\t" + QString::number(qint64(entry.size)));
+
+        while (!dirs.contains(dir)) {
+            dirs.insert(dir);
+            dir = parentDir(dir);
+        }
+    }
+
+    QStringList dirList = dirs.toList();
+    qSort(dirList.begin(), dirList.end(), deeperFirst);
+
+    QHash<QString, QString> tree;
+    foreach (QString dir, dirList) {
+        QStringList dirLines = lines.value(dir);
+        dirLines.sort();
+
+        QString digest = QString(QCryptographicHash::hash(dirLines.join("\n").toUtf8(),
+                                                          QCryptographicHash::Sha1).toHex());
+        tree[dir] = digest;
+
+        if (!dir.isEmpty()) {
+            lines[parentDir(dir)].append("d\t" + baseName(dir) + "\t" + digest);
+        }
+    }
+
+    return tree;
+}
+
+// Compares every entry, indexes may be in any order
+static FileTree::Diff compareAll(const GameIndex::FileIndex& oldIndex, const GameIndex::FileIndex& newIndex) {
+
+    FileTree::Diff result;
+
+    foreach (const GameIndex::Entry& entry, newIndex.getEntries()) {
+        const GameIndex::Entry* oldEntry = oldIndex.find(entry.path);
+
+        if (oldEntry == 0) {
+            result.added.insert(entry.path);
+        } else if (isSame(*oldEntry, entry)) {
+            result.unchanged.insert(entry.path);
+        } else {
+            result.changed.insert(entry.path);
+        }
+    }
+
+    foreach (const GameIndex::Entry& entry, oldIndex.getEntries()) {
+        if (newIndex.find(entry.path) == 0) result.removed.insert(entry.path);
+    }
+
+    return result;
+}
+
+FileTree::Diff FileTree::compare(const GameIndex::FileIndex& oldIndex, const QHash<QString, QString>& oldTree,
+                                 const GameIndex::FileIndex& newIndex, const QHash<QString, QString>& newTree) {
+
+    if (oldTree.isEmpty() || newTree.isEmpty() || !oldIndex.isSorted() || !newIndex.isSorted()) {
+        return compareAll(oldIndex, newIndex);
+    }
+
+    Diff result;
+
+    if (oldTree.value("") == newTree.value("")) {
+        result.unchangedDirs.insert("");
+        return result;
+    }
+
+    // Both indexes are walked together in path order, equal subtrees are jumped over
+    const QVector<GameIndex::Entry>& oldEntries = oldIndex.getEntries();
+    const QVector<GameIndex::Entry>& newEntries = newIndex.getEntries();
+    int i = 0, j = 0;
+
+    while (i < oldEntries.size() || j < newEntries.size()) {
+        bool takeOld = (j == newEntries.size())
+                || (i < oldEntries.size() && !(newEntries.at(j).path < oldEntries.at(i).path));
+        bool takeNew = (i == oldEntries.size())
+                || (j < newEntries.size() && !(oldEntries.at(i).path < newEntries.at(j).path));
+
+        QString path = takeOld ? oldEntries.at(i).path : newEntries.at(j).path;
+
+        QString dir = findEqualDir(path, oldTree, newTree);
+        if (!dir.isNull()) {
+            result.unchangedDirs.insert(dir);
+            i = skipSubtree(oldEntries, i, dir);
+            j = skipSubtree(newEntries, j, dir);
+            continue;
+        }
+
+        if (takeOld && takeNew) {
+            if (isSame(oldEntries.at(i), newEntries.at(j))) {
+                result.unchanged.insert(path);
+            } else {
+                result.changed.insert(path);
+            }
+            i++;
+            j++;
+        } else if (takeOld) {
+            result.removed.insert(path);
+            i++;
+        } else {
+            result.added.insert(path);
+            j++;
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,35 @@
+#ifndef FILETREE_H
+#define FILETREE_H
+
+#include <QtCore>
+
+#include "gameindex.h"
+
+// Directory-level (Merkle) digests over the files index of data.json.
+// Digest of a directory covers names, hashes and sizes of its files and
+// digests of its subdirectories, so equal digests mean equal subtrees.
+namespace FileTree {
+
+// Result of comparison of previous and current files indexes
+struct Diff {
+    QSet<QString> added;         // Only in current index
+    QSet<QString> removed;       // Only in previous index
+    QSet<QString> changed;       // In both indexes with different hash or size
+    QSet<QString> unchanged;     // Compared one by one, same hash and size
+    QSet<QString> unchangedDirs; // Subtrees with equal digests, their files are not listed
+
+    bool isUnchanged(const QString& path) const;
+};
+
+// Returns digest of every directory, "" is the root
+QHash<QString, QString> makeTree(const GameIndex::FileIndex& index);
+
+// Compares two files indexes. Subtrees with equal digests are skipped as a whole,
+// so only entries of changed directories are visited. Without trees (old data.json)
+// or sorted indexes every entry is compared.
+Diff compare(const GameIndex::FileIndex& oldIndex, const QHash<QString, QString>& oldTree,
+             const GameIndex::FileIndex& newIndex, const QHash<QString, QString>& newTree);
+
+}
+
+#endif // FILETREE_H
@@ -0,0 +1,179 @@
+#include "fingerprintcache.h"
+#include "settings.h"
+#include "storewatcher.h"
+
+#include <QCryptographicHash>
+#include <QSaveFile>
+
+FingerprintCache* FingerprintCache::myInstance = 0;
+FingerprintCache* FingerprintCache::instance() {
+    if (myInstance == 0) myInstance = new FingerprintCache();
+    return myInstance;
+}
+
+FingerprintCache::FingerprintCache(QObject *parent) :
+    QObject(parent)
+{
+    logger = Logger::logger();
+    cacheFileName = Settings::instance()->getBaseDir() + "/fingerprints.json";
+    modified = false;
+
+    load();
+}
+
+QString FingerprintCache::getFreshHash(QString fileName) {
+
+    StoreWatcher* watcher = StoreWatcher::instance();
+
+    // Events are dispatched by main loop, which may be blocked by the caller
+    watcher->sync();
+
+    // Touched files are rehashed even if size and mtime are preserved
+    if (watcher->isDirty(fileName)) return "";
+
+    quint64 generation = watcher->getGeneration();
+    bool watched = watcher->isWatched(fileName);
+
+    {
+        QMutexLocker locker(&mutex);
+
+        QHash<QString, Fingerprint>::const_iterator it = entries.constFind(fileName);
+        if (it == entries.constEnd()) return "";
+
+        // Verified while watcher is running and not touched since that
+        if (watched && it->generation == generation) return it->hash;
+    }
+
+    QFileInfo info(fileName);
+    if (!info.exists()) return "";
+
+    QMutexLocker locker(&mutex);
+
+    QHash<QString, Fingerprint>::iterator it = entries.find(fileName);
+    if (it == entries.end()) return "";
+
+    // File changed since last hash calculation
+    if (it->size != info.size() || it->mtime != info.lastModified().toMSecsSinceEpoch()) return "";
+
+    // Further changes will be reported by watcher
+    if (watched) it->generation = generation;
+
+    return it->hash;
+}
+
+QString FingerprintCache::getHash(QString fileName) {
+
+    QString hash = getFreshHash(fileName);
+    if (!hash.isEmpty()) return hash;
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) return "";
+
+    QCryptographicHash sha1(QCryptographicHash::Sha1);
+    sha1.addData(&file);
+    file.close();
+
+    hash = QString(sha1.result().toHex());
+    record(fileName, hash);
+
+    return hash;
+}
+
+bool FingerprintCache::verify(QString fileName, QString hash) {
+
+    if (!QFile::exists(fileName)) return false;
+    if (hash == "mutable") return true;
+
+    return getHash(fileName) == hash;
+}
+
+void FingerprintCache::record(QString fileName, QString hash) {
+
+    QFileInfo info(fileName);
+    if (!info.exists()) return;
+
+    StoreWatcher* watcher = StoreWatcher::instance();
+
+    Fingerprint fp;
+    fp.size = info.size();
+    fp.mtime = info.lastModified().toMSecsSinceEpoch();
+    fp.hash = hash;
+    fp.generation = watcher->isWatched(fileName) ? watcher->getGeneration() : 0;
+
+    watcher->markClean(fileName);
+
+    QMutexLocker locker(&mutex);
+    entries[fileName] = fp;
+    modified = true;
+}
+
+void FingerprintCache::remove(QString fileName) {
+
+    QMutexLocker locker(&mutex);
+    if (entries.remove(fileName) != 0) modified = true;
+}
+
+void FingerprintCache::load() {
+
+    QFile cacheFile(cacheFileName);
+    if (!cacheFile.open(QIODevice::ReadOnly)) return;
+
+    QJsonParseError error;
+    QJsonDocument json = QJsonDocument::fromJson(cacheFile.readAll(), &error);
+    cacheFile.close();
+
+    if (error.error != QJsonParseError::NoError) {
+        logger->append("FingerprintCache", "Error: can't parse cache, dropping it\n");
+        return;
+    }
+
+    QMutexLocker locker(&mutex);
+    entries.clear();
+
+    QJsonObject files = json.object()["files"].toObject();
+    for (QJsonObject::const_iterator it = files.constBegin(); it != files.constEnd(); ++it) {
+        QJsonObject entry = it.value().toObject();
+
+        Fingerprint fp;
+        fp.size = qint64(entry["size"].toDouble());
+        fp.mtime = qint64(entry["mtime"].toDouble());
+        fp.hash = entry["hash"].toString();
+        fp.generation = 0; // Not verified in current session
+
+        entries.insert(it.key(), fp);
+    }
+    modified = false;
+
+    logger->append("FingerprintCache", "Loaded " + QString::number(entries.size()) + " entries\n");
+}
+
+void FingerprintCache::save() {
+
+    QJsonObject files;
+    {
+        QMutexLocker locker(&mutex);
+        if (!modified) return;
+
+        for (QHash<QString, Fingerprint>::const_iterator it = entries.constBegin(); it != entries.constEnd(); ++it) {
+            QJsonObject entry;
+            entry["size"] = double(it->size);
+            entry["mtime"] = double(it->mtime);
+            entry["hash"] = it->hash;
+            files[it.key()] = entry;
+        }
+        modified = false;
+    }
+
+    QJsonObject root;
+    root["files"] = files;
+
+    QSaveFile cacheFile(cacheFileName);
+    if (cacheFile.open(QIODevice::WriteOnly)) {
+        cacheFile.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+        if (!cacheFile.commit()) {
+            logger->append("FingerprintCache", "Error: save cache: " + cacheFile.errorString() + "\n");
+        }
+    } else {
+        logger->append("FingerprintCache", "Error: save cache: " + cacheFile.errorString() + "\n");
+    }
+}
@@ -0,0 +1,54 @@
+#ifndef FINGERPRINTCACHE_H
+#define FINGERPRINTCACHE_H
+
+#include <QtCore>
+
+#include "logger.h"
+
+class FingerprintCache : public QObject
+{
+    Q_OBJECT
+public:
+    static FingerprintCache* instance();
+
+    // Fingerprint of a file at moment of the last hash calculation
+    struct Fingerprint {
+        qint64 size;
+        qint64 mtime;
+        QString hash;
+        quint64 generation; // Store watcher generation of last verification
+    };
+
+private:
+    static FingerprintCache* myInstance;
+
+    explicit FingerprintCache(QObject *parent = 0);
+
+    QString cacheFileName;
+    QHash<QString, Fingerprint> entries;
+    QMutex mutex;
+    bool modified;
+
+    Logger* logger;
+
+    FingerprintCache& operator=(FingerprintCache const&);
+    FingerprintCache(FingerprintCache const&);
+
+public:
+    // Returns cached hash if file is not changed since last record, or empty string
+    QString getFreshHash(QString fileName);
+
+    // Returns hash of the file, calculates it only if cached entry is outdated
+    QString getHash(QString fileName);
+
+    // Checks file existence and hash, rehashes only changed files
+    bool verify(QString fileName, QString hash);
+
+    void record(QString fileName, QString hash);
+    void remove(QString fileName);
+
+    void load();
+    void save();
+};
+
+#endif // FINGERPRINTCACHE_H
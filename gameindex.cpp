@@ -0,0 +1,278 @@
+#include "gameindex.h"
+#include "settings.h"
+
+namespace GameIndex {
+
+static Entry makeEntry(QString path, const QJsonObject& json) {
+    Entry entry;
+    entry.path = path;
+    entry.hash = json["hash"].toString();
+    entry.size = quint64(json["size"].toDouble());
+    return entry;
+}
+
+static void readFiles(const QJsonObject& json, FileIndex* index) {
+    index->reserve(json.size());
+    for (QJsonObject::const_iterator it = json.constBegin(); it != json.constEnd(); ++it) {
+        index->append(makeEntry(it.key(), it.value().toObject()));
+    }
+}
+
+FileIndex::FileIndex() {
+    sorted = true;
+}
+
+void FileIndex::reserve(int size) {
+    entries.reserve(size);
+    positions.reserve(size);
+}
+
+void FileIndex::append(const Entry& entry) {
+    if (!entries.isEmpty() && !(entries.last().path < entry.path)) sorted = false;
+    positions.insert(entry.path, entries.size());
+    entries.append(entry);
+}
+
+const Entry* FileIndex::find(QString path) const {
+    QHash<QString, int>::const_iterator it = positions.constFind(path);
+    if (it == positions.constEnd()) return 0;
+    return &entries.at(*it);
+}
+
+const QVector<Entry>& FileIndex::getEntries() const { return entries; }
+int FileIndex::size() const { return entries.size(); }
+bool FileIndex::isSorted() const { return sorted; }
+
+quint8 getPlatformBits(QString os, QString wordSize) {
+
+    quint8 bits = 0;
+    if (os == "linux") bits = Linux32 | Linux64;
+    if (os == "windows") bits = Windows32 | Windows64;
+    if (os == "osx") bits = Osx32 | Osx64;
+
+    if (wordSize == "32") bits &= Any32;
+    if (wordSize == "64") bits &= Any64;
+
+    return bits;
+}
+
+bool Library::isAllowed(QString os, QString wordSize) const {
+    return (platforms & getPlatformBits(os, wordSize)) != 0;
+}
+
+// Returns bits of platforms the rule is applied to
+static quint8 matchRule(const QJsonObject& rule) {
+
+    quint8 bits = AnyPlatform;
+    QJsonObject ruleOs = rule["os"].toObject();
+
+    if (ruleOs.contains("name")) bits &= getPlatformBits(ruleOs["name"].toString());
+
+    if (ruleOs.contains("arch")) {
+        QString arch = ruleOs["arch"].toString();
+        if (arch == "x86") {
+            bits &= Any32;
+        } else if (arch == "x86_64" || arch == "amd64") {
+            bits &= Any64;
+        } else {
+            bits = 0;
+        }
+    }
+
+    // Version of other systems is unknown, so version rule is checked for current system only
+    if (ruleOs.contains("version")) {
+        Settings* settings = Settings::instance();
+        QRegExp version(ruleOs["version"].toString());
+        if (version.indexIn(settings->getOsVersion()) == -1) bits &= ~getPlatformBits(settings->getOsName());
+    }
+
+    // No features are enabled, so only rules requiring disabled features are applied
+    QJsonObject features = rule["features"].toObject();
+    for (QJsonObject::const_iterator it = features.constBegin(); it != features.constEnd(); ++it) {
+        if (it.value().toBool()) bits = 0;
+    }
+
+    return bits;
+}
+
+// Last matched rule wins, library without rules is allowed everywhere
+static quint8 compileRules(const QJsonArray& rules) {
+
+    if (rules.isEmpty()) return AnyPlatform;
+
+    quint8 allowed = 0;
+    foreach (QJsonValue ruleValue, rules) {
+        QJsonObject rule = ruleValue.toObject();
+        QString action = rule["action"].toString();
+
+        if (action == "allow") allowed |= matchRule(rule);
+        if (action == "disallow") allowed &= ~matchRule(rule);
+    }
+
+    return allowed;
+}
+
+VersionIndex VersionIndex::fromJson(const QJsonObject& json) {
+
+    VersionIndex index;
+    index.id = json["id"].toString();
+    index.type = json["type"].toString();
+    index.releaseTime = json["releaseTime"].toString();
+    index.assets = json["assets"].toString();
+    index.mainClass = json["mainClass"].toString();
+    index.minecraftArguments = json["minecraftArguments"].toString();
+    index.javaMajor = int(json["javaVersion"].toObject()["majorVersion"].toDouble(8));
+
+    QJsonArray libraries = json["libraries"].toArray();
+    index.libraries.reserve(libraries.size());
+
+    foreach (QJsonValue libValue, libraries) {
+        QJsonObject libJson = libValue.toObject();
+
+        Library library;
+        library.name = libJson["name"].toString();
+        library.coordinate = MavenCoordinate(library.name);
+        library.url = libJson["url"].toString();
+
+        library.platforms = compileRules(libJson["rules"].toArray());
+
+        library.hasNatives = libJson["natives"].isObject();
+        QJsonObject natives = libJson["natives"].toObject();
+        for (QJsonObject::const_iterator it = natives.constBegin(); it != natives.constEnd(); ++it) {
+            library.natives.insert(it.key(), it.value().toString());
+        }
+
+        foreach (QJsonValue exclude, libJson["extract"].toObject()["exclude"].toArray()) {
+            library.excludes.append(exclude.toString());
+        }
+
+        index.libraries.append(library);
+    }
+
+    return index;
+}
+
+DataIndex DataIndex::fromJson(const QJsonObject& json) {
+
+    DataIndex index;
+    index.main = makeEntry(QString(), json["main"].toObject());
+    index.memory = int(json["memory"].toDouble());
+
+    readFiles(json["libs"].toObject(), &index.libs);
+
+    QJsonObject files = json["files"].toObject();
+    readFiles(files["index"].toObject(), &index.files);
+
+    QJsonObject tree = files["tree"].toObject();
+    for (QJsonObject::const_iterator it = tree.constBegin(); it != tree.constEnd(); ++it) {
+        index.filesTree.insert(it.key(), it.value().toString());
+    }
+
+    foreach (QJsonValue value, files["mutables"].toArray()) {
+        index.mutables.append(value.toString());
+    }
+
+    return index;
+}
+
+AssetsIndex AssetsIndex::fromJson(const QJsonObject& json) {
+
+    AssetsIndex index;
+    readFiles(json["objects"].toObject(), &index.objects);
+    return index;
+}
+
+static QDataStream& operator<<(QDataStream& out, const Entry& entry) {
+    out << entry.path << entry.hash << entry.size;
+    return out;
+}
+
+static QDataStream& operator>>(QDataStream& in, Entry& entry) {
+    in >> entry.path >> entry.hash >> entry.size;
+    return in;
+}
+
+static QDataStream& operator<<(QDataStream& out, const FileIndex& index) {
+    out << quint32(index.size());
+    foreach (const Entry& entry, index.getEntries()) out << entry;
+    return out;
+}
+
+// Lookup table is rebuilt, entries are not parsed from JSON
+static QDataStream& operator>>(QDataStream& in, FileIndex& index) {
+    quint32 count;
+    in >> count;
+    if (in.status() != QDataStream::Ok) return in;
+
+    index = FileIndex();
+    index.reserve(int(count));
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; i++) {
+        Entry entry;
+        in >> entry;
+        index.append(entry);
+    }
+    return in;
+}
+
+static QDataStream& operator<<(QDataStream& out, const Library& library) {
+    out << library.name << library.url << library.platforms << library.hasNatives
+        << library.natives << library.excludes;
+    return out;
+}
+
+static QDataStream& operator>>(QDataStream& in, Library& library) {
+    in >> library.name >> library.url >> library.platforms >> library.hasNatives
+       >> library.natives >> library.excludes;
+    library.coordinate = MavenCoordinate(library.name);
+    return in;
+}
+
+QDataStream& operator<<(QDataStream& out, const VersionIndex& index) {
+    out << index.id << index.type << index.releaseTime << index.assets << index.mainClass
+        << index.minecraftArguments << qint32(index.javaMajor) << quint32(index.libraries.size());
+    foreach (const Library& library, index.libraries) out << library;
+    return out;
+}
+
+QDataStream& operator>>(QDataStream& in, VersionIndex& index) {
+    qint32 javaMajor;
+    quint32 count;
+    in >> index.id >> index.type >> index.releaseTime >> index.assets >> index.mainClass
+       >> index.minecraftArguments >> javaMajor >> count;
+    index.javaMajor = javaMajor;
+
+    index.libraries.clear();
+    if (in.status() != QDataStream::Ok) return in;
+
+    index.libraries.reserve(int(count));
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; i++) {
+        Library library;
+        in >> library;
+        index.libraries.append(library);
+    }
+    return in;
+}
+
+QDataStream& operator<<(QDataStream& out, const DataIndex& index) {
+    out << index.main << index.libs << index.files << index.filesTree << index.mutables << qint32(index.memory);
+    return out;
+}
+
+QDataStream& operator>>(QDataStream& in, DataIndex& index) {
+    qint32 memory;
+    in >> index.main >> index.libs >> index.files >> index.filesTree >> index.mutables >> memory;
+    index.memory = memory;
+    return in;
+}
+
+QDataStream& operator<<(QDataStream& out, const AssetsIndex& index) {
+    out << index.objects;
+    return out;
+}
+
+QDataStream& operator>>(QDataStream& in, AssetsIndex& index) {
+    in >> index.objects;
+    return in;
+}
+
+}
@@ -0,0 +1,104 @@
+#ifndef GAMEINDEX_H
+#define GAMEINDEX_H
+
+#include <QtCore>
+
+#include "mavencoordinate.h"
+
+// Typed model of version, data and assets indexes. Each index is converted
+// from parsed JSON in a single pass, entries are kept in contiguous arrays
+// with lookup by path, so consumers do not walk JSON objects per entry.
+namespace GameIndex {
+
+// File entry of data or assets index
+struct Entry {
+    QString path; // Library suffix, custom file path or asset key
+    QString hash;
+    quint64 size;
+};
+
+class FileIndex
+{
+public:
+    FileIndex();
+
+    void reserve(int size);
+    void append(const Entry& entry);
+
+    const Entry* find(QString path) const; // 0 if not found
+    const QVector<Entry>& getEntries() const;
+    int size() const;
+    bool isSorted() const; // Entries were appended in path order
+
+private:
+    QVector<Entry> entries;
+    QHash<QString, int> positions;
+    bool sorted;
+};
+
+// Platform bits of compiled library rules
+enum Platform {
+    Linux32 = 0x01, Linux64 = 0x02,
+    Windows32 = 0x04, Windows64 = 0x08,
+    Osx32 = 0x10, Osx64 = 0x20,
+    Any32 = Linux32 | Windows32 | Osx32,
+    Any64 = Linux64 | Windows64 | Osx64,
+    AnyPlatform = Any32 | Any64
+};
+
+// Returns bits of os with given word size ("32" or "64"), or of both word sizes if it is empty
+quint8 getPlatformBits(QString os, QString wordSize = QString());
+
+struct Library {
+    QString name;     // <group>:<name>:<version>[:<classifier>][@<extension>]
+    MavenCoordinate coordinate;
+    QString url;      // Custom repository
+    quint8 platforms; // Allow-disallow rules compiled to platform bits
+    bool hasNatives;
+    QHash<QString, QString> natives; // os -> natives suffix
+    QStringList excludes;            // Entries of native library not to be extracted
+
+    bool isAllowed(QString os, QString wordSize = QString()) const;
+};
+
+struct VersionIndex {
+    QString id;
+    QString type;
+    QString releaseTime;
+    QString assets;
+    QString mainClass;
+    QString minecraftArguments;
+    int javaMajor; // 8 if not specified
+    QVector<Library> libraries;
+
+    static VersionIndex fromJson(const QJsonObject& json);
+};
+
+struct DataIndex {
+    Entry main;
+    FileIndex libs;
+    FileIndex files;
+    QHash<QString, QString> filesTree; // Directory digests of files index, see FileTree
+    QStringList mutables;
+    int memory; // Recommended heap size in MiB, 0 if not specified
+
+    static DataIndex fromJson(const QJsonObject& json);
+};
+
+struct AssetsIndex {
+    FileIndex objects;
+
+    static AssetsIndex fromJson(const QJsonObject& json);
+};
+
+// Compiled form of indexes, see IndexCache
+QDataStream& operator<<(QDataStream& out, const VersionIndex& index);
+QDataStream& operator>>(QDataStream& in, VersionIndex& index);
+QDataStream& operator<<(QDataStream& out, const DataIndex& index);
+QDataStream& operator>>(QDataStream& in, DataIndex& index);
+QDataStream& operator<<(QDataStream& out, const AssetsIndex& index);
+QDataStream& operator>>(QDataStream& in, AssetsIndex& index);
+
+}
+
+#endif // GAMEINDEX_H
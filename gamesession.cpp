@@ -0,0 +1,136 @@
+#include "gamesession.h"
+#include "settings.h"
+
+// Output is written by chunks, but not later than flush interval
+static const int outputBufferLimit = 64 * 1024;
+static const int outputFlushInterval = 500;
+
+GameSession::GameSession(QObject *parent) :
+    QObject(parent)
+{
+    logger = Logger::logger();
+    processStarted = false;
+    outputSeen = false;
+
+    limits.nice = 0;
+    limits.memoryLimit = 0;
+
+    process = new LimitedProcess(this);
+    process->setProcessChannelMode(QProcess::MergedChannels);
+
+    connect(process, SIGNAL(started()), this, SLOT(onStarted()));
+    connect(process, SIGNAL(error(QProcess::ProcessError)), this, SLOT(onError(QProcess::ProcessError)));
+    connect(process, SIGNAL(finished(int,QProcess::ExitStatus)), this, SLOT(onFinished(int,QProcess::ExitStatus)));
+    connect(process, SIGNAL(readyReadStandardOutput()), this, SLOT(readOutput()));
+
+    flushTimer = new QTimer(this);
+    flushTimer->setSingleShot(true);
+    connect(flushTimer, SIGNAL(timeout()), this, SLOT(flushOutput()));
+
+    logFile = 0;
+}
+
+GameSession::~GameSession() {
+    flushOutput();
+    delete logFile;
+}
+
+void GameSession::openLog() {
+
+    QString baseDir = Settings::instance()->getBaseDir();
+
+    // Rotate logs, same way as launcher log
+    int rotations = 3;
+    QFile::remove(baseDir + "/client." + QString::number(rotations - 1) + ".log");
+    for (int i = rotations - 2; i >= 0; i--) {
+        QFile::rename(baseDir + "/client." + QString::number(i) + ".log",
+                      baseDir + "/client." + QString::number(i + 1) + ".log");
+    }
+
+    logFile = new QFile(baseDir + "/client.0.log");
+    if (!logFile->open(QIODevice::WriteOnly)) {
+        logger->append("GameSession", "Error: can't open client log: " + logFile->errorString() + "\n");
+        delete logFile;
+        logFile = 0;
+    }
+}
+
+void GameSession::setLimits(const ResourceControls::Limits& limits) {
+    this->limits = limits;
+}
+
+void GameSession::start(QString java, QStringList args, QString workingDir) {
+
+    openLog();
+
+    // Cores and nice are applied by process itself, memory ceiling by cgroup
+    process->setLimits(limits);
+    ResourceControls::wrapCommand(limits, &java, &args);
+
+    process->setWorkingDirectory(workingDir);
+    startTimer.start();
+    process->start(java, args);
+}
+
+QProcess::ProcessError GameSession::getError() { return process->error(); }
+QString GameSession::getErrorString() { return process->errorString(); }
+qint64 GameSession::getElapsed() { return startTimer.elapsed(); }
+
+void GameSession::onStarted() {
+
+    processStarted = true;
+    logger->append("GameSession", "Game process started, output is written to client.0.log\n");
+    emit started();
+}
+
+void GameSession::onError(QProcess::ProcessError error) {
+
+    // Errors of running process are reported with exit status
+    if (processStarted) return;
+
+    logger->append("GameSession", "Error: can't start game process: error " + QString::number(error)
+                   + ", " + process->errorString() + "\n");
+    emit failed();
+}
+
+void GameSession::onFinished(int exitCode, QProcess::ExitStatus exitStatus) {
+
+    readOutput();
+    flushOutput();
+
+    bool crashed = (exitStatus == QProcess::CrashExit);
+    logger->append("GameSession", "Game process finished, exit code " + QString::number(exitCode)
+                   + (crashed ? ", crashed\n" : "\n"));
+
+    emit finished(exitCode, crashed);
+}
+
+void GameSession::readOutput() {
+
+    QByteArray output = process->readAllStandardOutput();
+    if (!outputSeen && !output.isEmpty()) {
+        outputSeen = true;
+        qint64 startupTime = startTimer.elapsed();
+        logger->append("GameSession", "First game output in " + QString::number(startupTime) + " ms\n");
+        emit firstOutput(startupTime);
+    }
+    outputBuffer.append(output);
+
+    if (outputBuffer.size() >= outputBufferLimit) {
+        flushOutput();
+    } else if (!outputBuffer.isEmpty() && !flushTimer->isActive()) {
+        flushTimer->start(outputFlushInterval);
+    }
+}
+
+void GameSession::flushOutput() {
+
+    flushTimer->stop();
+    if (outputBuffer.isEmpty()) return;
+
+    if (logFile != 0) {
+        logFile->write(outputBuffer);
+        logFile->flush();
+    }
+    outputBuffer.clear();
+}
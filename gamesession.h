@@ -0,0 +1,57 @@
+#ifndef GAMESESSION_H
+#define GAMESESSION_H
+
+#include <QtCore>
+
+#include "logger.h"
+#include "resourcecontrols.h"
+
+// Running game process. Output of the game is written to its own
+// rotating log (client.N.log), process state is reported by signals.
+class GameSession : public QObject
+{
+    Q_OBJECT
+public:
+    explicit GameSession(QObject *parent = 0);
+    ~GameSession();
+
+    void setLimits(const ResourceControls::Limits& limits);
+    void start(QString java, QStringList args, QString workingDir);
+
+    QProcess::ProcessError getError();
+    QString getErrorString();
+
+    qint64 getElapsed(); // Milliseconds since start
+
+private:
+    Logger* logger;
+
+    LimitedProcess* process;
+    ResourceControls::Limits limits;
+    bool processStarted;
+
+    QElapsedTimer startTimer;
+    bool outputSeen;
+
+    QFile* logFile;
+    QByteArray outputBuffer;
+    QTimer* flushTimer;
+
+    void openLog();
+
+signals:
+    void started();
+    void failed();
+    void firstOutput(qint64 startupTime); // Milliseconds from start to the first output
+    void finished(int exitCode, bool crashed);
+
+private slots:
+    void onStarted();
+    void onError(QProcess::ProcessError error);
+    void onFinished(int exitCode, QProcess::ExitStatus exitStatus);
+    void readOutput();
+    void flushOutput();
+
+};
+
+#endif // GAMESESSION_H
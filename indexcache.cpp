@@ -0,0 +1,156 @@
+#include "indexcache.h"
+
+#include "logger.h"
+#include "settings.h"
+#include "fingerprintcache.h"
+
+#include <QCryptographicHash>
+#include <QSaveFile>
+
+static const quint32 indexCacheMagic = 0x7474796A; // "ttyj"
+static const quint32 indexCacheFormat = 3;
+
+// Kind of model, so cache of one index is never read as another
+static quint32 getKind(const GameIndex::VersionIndex*) { return 1; }
+static quint32 getKind(const GameIndex::DataIndex*) { return 2; }
+static quint32 getKind(const GameIndex::AssetsIndex*) { return 3; }
+
+static QString getCacheFileName(QString fileName) {
+    return fileName + ".bin";
+}
+
+// Library rules are compiled for the current system, so it is a part of the key
+static QString getSystem() {
+    Settings* settings = Settings::instance();
+    return settings->getOsName() + "/" + settings->getWordSize() + "/" + settings->getOsVersion();
+}
+
+template <class Index>
+static bool loadCompiled(QString fileName, QByteArray hash, Index* index) {
+
+    QFile cacheFile(getCacheFileName(fileName));
+    if (!cacheFile.open(QIODevice::ReadOnly)) return false;
+
+    QDataStream in(&cacheFile);
+    in.setVersion(QDataStream::Qt_5_0);
+
+    quint32 magic, format, kind;
+    QByteArray sourceHash;
+    QString system;
+
+    in >> magic >> format >> kind;
+    if (magic != indexCacheMagic || format != indexCacheFormat || kind != getKind(index)) return false;
+
+    in >> sourceHash >> system;
+    if (in.status() != QDataStream::Ok || sourceHash != hash || system != getSystem()) return false;
+
+    Index compiled;
+    in >> compiled;
+    if (in.status() != QDataStream::Ok) return false;
+
+    *index = compiled;
+    return true;
+}
+
+template <class Index>
+static void saveCompiled(QString fileName, QByteArray hash, const Index& index) {
+
+    QSaveFile cacheFile(getCacheFileName(fileName));
+    if (!cacheFile.open(QIODevice::WriteOnly)) {
+        Logger::logger()->append("IndexCache", "Error: save cache: " + cacheFile.errorString() + "\n");
+        return;
+    }
+
+    QDataStream out(&cacheFile);
+    out.setVersion(QDataStream::Qt_5_0);
+    out << indexCacheMagic << indexCacheFormat << getKind(&index) << hash << getSystem() << index;
+
+    if (!cacheFile.commit()) {
+        Logger::logger()->append("IndexCache", "Error: save cache: " + cacheFile.errorString() + "\n");
+    }
+}
+
+// Cold path: JSON is parsed once and converted to the model
+template <class Index>
+static Index compile(QString fileName, const QByteArray& source, QByteArray hash, QString* errorString) {
+
+    QJsonParseError error;
+    QJsonDocument json = QJsonDocument::fromJson(source, &error);
+
+    if (error.error != QJsonParseError::NoError) {
+        if (errorString != 0) {
+            *errorString = "can't parse " + QFileInfo(fileName).fileName() + ": "
+                    + error.errorString() + " at " + QString::number(error.offset);
+        }
+        return Index::fromJson(QJsonObject());
+    }
+
+    Index index = Index::fromJson(json.object());
+    saveCompiled(fileName, hash, index);
+    return index;
+}
+
+template <class Index>
+static Index readIndex(QString fileName, bool* found, QString* errorString) {
+
+    if (found != 0) *found = QFile::exists(fileName);
+    if (errorString != 0) errorString->clear();
+
+    // Hash of unchanged file is known without reading it
+    QByteArray hash = FingerprintCache::instance()->getHash(fileName).toLatin1();
+    if (hash.isEmpty()) return Index::fromJson(QJsonObject());
+
+    Index index;
+    if (loadCompiled(fileName, hash, &index)) return index;
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) return Index::fromJson(QJsonObject());
+
+    QByteArray source = file.readAll();
+    file.close();
+
+    // File could be changed after hashing
+    hash = QCryptographicHash::hash(source, QCryptographicHash::Sha1).toHex();
+    return compile<Index>(fileName, source, hash, errorString);
+}
+
+template <class Index>
+static Index parseIndex(QString fileName, const QByteArray& source, QString* errorString) {
+
+    if (errorString != 0) errorString->clear();
+
+    QByteArray hash = QCryptographicHash::hash(source, QCryptographicHash::Sha1).toHex();
+
+    Index index;
+    if (loadCompiled(fileName, hash, &index)) return index;
+
+    return compile<Index>(fileName, source, hash, errorString);
+}
+
+namespace IndexCache {
+
+GameIndex::VersionIndex readVersion(QString fileName, bool* found, QString* errorString) {
+    return readIndex<GameIndex::VersionIndex>(fileName, found, errorString);
+}
+
+GameIndex::DataIndex readData(QString fileName, bool* found, QString* errorString) {
+    return readIndex<GameIndex::DataIndex>(fileName, found, errorString);
+}
+
+GameIndex::AssetsIndex readAssets(QString fileName, bool* found, QString* errorString) {
+    return readIndex<GameIndex::AssetsIndex>(fileName, found, errorString);
+}
+
+GameIndex::VersionIndex parseVersion(QString fileName, const QByteArray& source, QString* errorString) {
+    return parseIndex<GameIndex::VersionIndex>(fileName, source, errorString);
+}
+
+GameIndex::DataIndex parseData(QString fileName, const QByteArray& source, QString* errorString) {
+    return parseIndex<GameIndex::DataIndex>(fileName, source, errorString);
+}
+
+GameIndex::AssetsIndex parseAssets(QString fileName, const QByteArray& source, QString* errorString) {
+    return parseIndex<GameIndex::AssetsIndex>(fileName, source, errorString);
+}
+
+}
@@ -0,0 +1,29 @@
+#ifndef INDEXCACHE_H
+#define INDEXCACHE_H
+
+#include <QtCore>
+
+#include "gameindex.h"
+
+// Typed models of version, data and assets indexes are kept next to the source
+// as <name>.json.bin (QDataStream of GameIndex structs) with SHA-1 of the source.
+// Valid cache is loaded without building a JSON tree: entries are read straight
+// into the model, only the lookup table is rebuilt.
+namespace IndexCache {
+
+// Reads index file, source is hashed only if changed since last verification.
+// Missing or broken index gives an empty model.
+GameIndex::VersionIndex readVersion(QString fileName, bool* found = 0, QString* errorString = 0);
+GameIndex::DataIndex readData(QString fileName, bool* found = 0, QString* errorString = 0);
+GameIndex::AssetsIndex readAssets(QString fileName, bool* found = 0, QString* errorString = 0);
+
+// Same for source already read by caller. Cache is kept next to fileName, so
+// copies living outside of versions (installed_data.json of a prefix) are cached
+// under a name in the version directory.
+GameIndex::VersionIndex parseVersion(QString fileName, const QByteArray& source, QString* errorString = 0);
+GameIndex::DataIndex parseData(QString fileName, const QByteArray& source, QString* errorString = 0);
+GameIndex::AssetsIndex parseAssets(QString fileName, const QByteArray& source, QString* errorString = 0);
+
+}
+
+#endif // INDEXCACHE_H
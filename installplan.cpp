@@ -0,0 +1,368 @@
+#include "installplan.h"
+
+#include "settings.h"
+#include "logger.h"
+#include "indexcache.h"
+
+#include <QCryptographicHash>
+#include <QSaveFile>
+
+static const quint32 planCacheMagic = 0x74747970; // "ttyp"
+static const quint32 planCacheFormat = 5;
+
+static QByteArray readIndex(QString fileName, bool* found) {
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        *found = false;
+        return QByteArray();
+    }
+
+    *found = true;
+    QByteArray data = file.readAll();
+    file.close();
+    return data;
+}
+
+static QDataStream& operator<<(QDataStream& out, const InstallPlan::Artifact& a) {
+    out << qint32(a.kind) << a.name << a.url << a.path << a.hash << a.size << a.native << a.repository << a.excludes;
+    return out;
+}
+
+static QDataStream& operator>>(QDataStream& in, InstallPlan::Artifact& a) {
+    qint32 kind;
+    in >> kind >> a.name >> a.url >> a.path >> a.hash >> a.size >> a.native >> a.repository >> a.excludes;
+    a.kind = InstallPlan::Kind(kind);
+    return in;
+}
+
+InstallPlan::InstallPlan() {
+    platforms = CurrentPlatform;
+    error = NoError;
+    dataIndexFound = false;
+    assetsIndexFound = false;
+    memoryHint = 0;
+}
+
+InstallPlan::Error InstallPlan::getError() { return error; }
+QString InstallPlan::getErrorString() { return errorString; }
+
+QString InstallPlan::getVersion() { return version; }
+QString InstallPlan::getAssetsId() { return assetsId; }
+QString InstallPlan::getMainClass() { return mainClass; }
+QString InstallPlan::getMinecraftArguments() { return minecraftArguments; }
+int InstallPlan::getMemoryHint() { return memoryHint; }
+
+bool InstallPlan::hasDataIndex() { return dataIndexFound; }
+bool InstallPlan::hasAssetsIndex() { return assetsIndexFound; }
+
+QList<InstallPlan::Artifact> InstallPlan::getArtifacts() { return artifacts; }
+
+QList<InstallPlan::Artifact> InstallPlan::getArtifacts(Kind kind) {
+    QList<Artifact> result;
+    foreach (const Artifact& artifact, artifacts) {
+        if (artifact.kind == kind) result.append(artifact);
+    }
+    return result;
+}
+
+QString InstallPlan::getCacheFileName() {
+    QString suffix = (platforms == AllPlatforms) ? "_all" : "";
+    return Settings::instance()->getVersionsDir(client) + "/" + version + "/install_plan" + suffix + ".dat";
+}
+
+bool InstallPlan::resolve(QString client, QString version, Platforms platforms) {
+
+    Logger* logger = Logger::logger();
+    Settings* settings = Settings::instance();
+
+    this->client = client;
+    this->version = version;
+    this->platforms = platforms;
+
+    error = NoError;
+    errorString.clear();
+    artifacts.clear();
+
+    QString versionPrefix = settings->getVersionsDir(client) + "/" + version + "/";
+
+    bool found;
+    QByteArray versionData = readIndex(versionPrefix + version + ".json", &found);
+    if (!found) {
+        error = IndexNotFound;
+        errorString = "can't open " + version + ".json";
+        logger->append("InstallPlan", "Error: " + errorString + "\n");
+        return false;
+    }
+
+    // Builder tools make data index by themselves, so hashes are not needed
+    QByteArray dataData;
+    if (platforms == CurrentPlatform) {
+        dataData = readIndex(versionPrefix + "data.json", &dataIndexFound);
+    } else {
+        dataIndexFound = false;
+    }
+
+    if (loadCache(versionData, dataData)) {
+        logger->append("InstallPlan", "Using cached plan for " + client + "/" + version + "\n");
+        return true;
+    }
+
+    logger->append("InstallPlan", "Resolving plan for " + client + "/" + version + "\n");
+
+    // Assets index name is known only from version index
+    GameIndex::VersionIndex versionIndex = IndexCache::parseVersion(versionPrefix + version + ".json", versionData, &errorString);
+    if (!errorString.isEmpty()) {
+        error = IndexParseError;
+        logger->append("InstallPlan", "Error: " + errorString + "\n");
+        return false;
+    }
+
+    QString assets = versionIndex.assets;
+    QByteArray assetsData;
+    assetsIndexFound = false;
+    if (!assets.isEmpty()) {
+        assetsData = readIndex(settings->getAssetsDir() + "/indexes/" + assets + ".json", &assetsIndexFound);
+    }
+
+    if (!build(versionIndex, dataData, assetsData)) {
+        logger->append("InstallPlan", "Error: " + errorString + "\n");
+        return false;
+    }
+
+    saveCache(makeKey(versionData, dataData, assetsData));
+    return true;
+}
+
+QByteArray InstallPlan::makeKey(const QByteArray& versionData, const QByteArray& dataData, const QByteArray& assetsData) {
+
+    Settings* settings = Settings::instance();
+
+    QCryptographicHash key(QCryptographicHash::Sha1);
+    key.addData(QString(client + "/" + version + "/" + QString::number(platforms) + "/"
+                        + settings->getOsName() + "/" + settings->getWordSize() + "/"
+                        + settings->getOsVersion()).toUtf8());
+
+    // Each index are hashed separately to avoid collisions at borders
+    key.addData(QCryptographicHash::hash(versionData, QCryptographicHash::Sha1));
+    key.addData(dataIndexFound ? QCryptographicHash::hash(dataData, QCryptographicHash::Sha1) : QByteArray("-"));
+    key.addData(assetsIndexFound ? QCryptographicHash::hash(assetsData, QCryptographicHash::Sha1) : QByteArray("-"));
+
+    return key.result();
+}
+
+bool InstallPlan::loadCache(const QByteArray& versionData, const QByteArray& dataData) {
+
+    QFile cacheFile(getCacheFileName());
+    if (!cacheFile.open(QIODevice::ReadOnly)) return false;
+
+    QDataStream in(&cacheFile);
+    in.setVersion(QDataStream::Qt_5_0);
+
+    quint32 magic, format;
+    QByteArray key;
+
+    in >> magic >> format;
+    if (magic != planCacheMagic || format != planCacheFormat) return false;
+
+    in >> assetsId >> key;
+
+    bool found = false;
+    QByteArray assetsData;
+    if (!assetsId.isEmpty()) {
+        assetsData = readIndex(Settings::instance()->getAssetsDir() + "/indexes/" + assetsId + ".json", &found);
+    }
+    assetsIndexFound = found;
+
+    // Some of indexes changed since plan was resolved
+    if (key != makeKey(versionData, dataData, assetsData)) return false;
+
+    quint32 count;
+    qint32 memory;
+    in >> mainClass >> minecraftArguments >> memory >> count;
+    memoryHint = memory;
+
+    artifacts.clear();
+    artifacts.reserve(int(count));
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; i++) {
+        Artifact artifact;
+        in >> artifact;
+        artifacts.append(artifact);
+    }
+
+    if (in.status() != QDataStream::Ok) {
+        artifacts.clear();
+        return false;
+    }
+
+    return true;
+}
+
+void InstallPlan::saveCache(const QByteArray& key) {
+
+    QSaveFile cacheFile(getCacheFileName());
+    if (!cacheFile.open(QIODevice::WriteOnly)) {
+        Logger::logger()->append("InstallPlan", "Error: save plan: " + cacheFile.errorString() + "\n");
+        return;
+    }
+
+    QDataStream out(&cacheFile);
+    out.setVersion(QDataStream::Qt_5_0);
+
+    out << planCacheMagic << planCacheFormat << assetsId << key;
+    out << mainClass << minecraftArguments << qint32(memoryHint) << quint32(artifacts.size());
+    foreach (const Artifact& artifact, artifacts) {
+        out << artifact;
+    }
+
+    if (!cacheFile.commit()) {
+        Logger::logger()->append("InstallPlan", "Error: save plan: " + cacheFile.errorString() + "\n");
+    }
+}
+
+void InstallPlan::addLibrary(QString suffix, const GameIndex::Library& library, const GameIndex::FileIndex& libIndex,
+                             bool native) {
+
+    Settings* settings = Settings::instance();
+    const GameIndex::Entry* entry = libIndex.find(suffix);
+
+    Artifact artifact;
+    artifact.kind = Library;
+    artifact.name = suffix;
+    artifact.url = settings->getLibsUrl() + suffix;
+    artifact.path = settings->getLibsDir() + "/" + suffix;
+    artifact.hash = (entry != 0) ? entry->hash : QString();
+    artifact.size = (entry != 0) ? entry->size : 0;
+    artifact.native = native;
+    artifact.repository = library.url;
+    if (native) artifact.excludes = library.excludes;
+
+    artifacts.append(artifact);
+}
+
+bool InstallPlan::build(const GameIndex::VersionIndex& versionIndex, const QByteArray& dataData,
+                        const QByteArray& assetsData) {
+
+    Settings* settings = Settings::instance();
+    QString versionPrefix = settings->getVersionsDir(client) + "/" + version + "/";
+
+    // Models are loaded from compiled cache when sources are not changed
+    GameIndex::DataIndex dataIndex;
+    if (dataIndexFound) {
+        dataIndex = IndexCache::parseData(versionPrefix + "data.json", dataData, &errorString);
+        if (!errorString.isEmpty()) {
+            error = IndexParseError;
+            return false;
+        }
+    } else {
+        dataIndex = GameIndex::DataIndex::fromJson(QJsonObject());
+    }
+
+    GameIndex::AssetsIndex assetsIndex;
+    if (assetsIndexFound) {
+        assetsIndex = IndexCache::parseAssets(settings->getAssetsDir() + "/indexes/" + versionIndex.assets + ".json",
+                                              assetsData, &errorString);
+        if (!errorString.isEmpty()) {
+            error = IndexParseError;
+            errorString = "can't parse assets index " + errorString.mid(QString("can't parse ").length());
+            return false;
+        }
+    }
+
+    assetsId = versionIndex.assets;
+    mainClass = versionIndex.mainClass;
+    minecraftArguments = versionIndex.minecraftArguments;
+    memoryHint = dataIndex.memory;
+
+    QString versionUrlPrefix = settings->getVersionUrl(client, version);
+
+    // Main file
+    Artifact mainJar;
+    mainJar.kind = MainJar;
+    mainJar.name = version + ".jar";
+    mainJar.url = versionUrlPrefix + version + ".jar";
+    mainJar.path = versionPrefix + version + ".jar";
+    mainJar.hash = dataIndex.main.hash;
+    mainJar.size = dataIndex.main.size;
+    mainJar.native = false;
+    artifacts.append(mainJar);
+
+    // Libraries (in classpath order)
+    QStringList oslist;
+    if (platforms == AllPlatforms) {
+        oslist << "linux" << "windows" << "osx";
+    } else {
+        oslist << settings->getOsName();
+    }
+
+    // Word size matters for current platform only
+    QString wordSize = (platforms == CurrentPlatform) ? settings->getWordSize() : QString();
+
+    foreach (const GameIndex::Library& library, versionIndex.libraries) {
+        const MavenCoordinate& coordinate = library.coordinate;
+        if (!coordinate.isValid()) continue;
+
+        foreach (QString os, oslist) {
+            if (!library.isAllowed(os, wordSize)) continue;
+
+            // Natives entry has its classifier: <group>/<name>-<version>-<natives classifier>
+            QString nativesSuffix = library.natives.value(os);
+
+            if (!library.hasNatives) {
+                addLibrary(coordinate.getPath(), library, dataIndex.libs, false);
+                break; // Common library are same for all platforms
+
+            } else if (platforms == CurrentPlatform) {
+                nativesSuffix.replace("${arch}", settings->getWordSize());
+                addLibrary(coordinate.getPath(nativesSuffix), library, dataIndex.libs, true);
+
+            } else if (!nativesSuffix.isEmpty()) {
+                if (nativesSuffix.contains("${arch}")) {
+                    QString n32 = nativesSuffix;
+                    QString n64 = nativesSuffix;
+                    addLibrary(coordinate.getPath(n32.replace("${arch}", "32")), library, dataIndex.libs, true);
+                    addLibrary(coordinate.getPath(n64.replace("${arch}", "64")), library, dataIndex.libs, true);
+                } else {
+                    addLibrary(coordinate.getPath(nativesSuffix), library, dataIndex.libs, true);
+                }
+            }
+        }
+    }
+
+    // Assets
+    QString assetsFilePrefix = settings->getAssetsDir() + "/objects/";
+    QString assetsUrlPrefix = settings->getAssetsUrl() + "objects/";
+
+    artifacts.reserve(artifacts.size() + assetsIndex.objects.size() + dataIndex.files.size());
+
+    foreach (const GameIndex::Entry& asset, assetsIndex.objects.getEntries()) {
+        Artifact artifact;
+        artifact.kind = Asset;
+        artifact.name = asset.path;
+        artifact.hash = asset.hash;
+        artifact.size = asset.size;
+        artifact.url = assetsUrlPrefix + artifact.hash.mid(0, 2) + "/" + artifact.hash;
+        artifact.path = assetsFilePrefix + artifact.hash.mid(0, 2) + "/" + artifact.hash;
+        artifact.native = false;
+        artifacts.append(artifact);
+    }
+
+    // Additional files
+    QSet<QString> mutables = dataIndex.mutables.toSet();
+
+    QString filesFilePrefix = settings->getClientPrefix(client, version) + "/";
+    QString filesUrlPrefix = versionUrlPrefix + "files/";
+
+    foreach (const GameIndex::Entry& customFile, dataIndex.files.getEntries()) {
+        Artifact artifact;
+        artifact.kind = CustomFile;
+        artifact.name = customFile.path;
+        artifact.hash = mutables.contains(customFile.path) ? "mutable" : customFile.hash;
+        artifact.size = customFile.size;
+        artifact.url = filesUrlPrefix + customFile.path;
+        artifact.path = filesFilePrefix + customFile.path;
+        artifact.native = false;
+        artifacts.append(artifact);
+    }
+
+    return true;
+}
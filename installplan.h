@@ -0,0 +1,76 @@
+#ifndef INSTALLPLAN_H
+#define INSTALLPLAN_H
+
+#include <QtCore>
+
+#include "gameindex.h"
+
+// Flat list of game files for (client, version), resolved from version,
+// data and assets indexes. Resolved plan is cached next to the version index.
+// Plans for all platforms are used by builder tools and have no hashes.
+class InstallPlan
+{
+public:
+    enum Platforms { CurrentPlatform, AllPlatforms };
+    enum Kind { MainJar, Library, Asset, CustomFile };
+    enum Error { NoError, IndexNotFound, IndexParseError };
+
+    struct Artifact {
+        Kind kind;
+        QString name;       // Relative name: library suffix, asset key or custom file path
+        QString url;        // Update server url
+        QString path;       // Local file name
+        QString hash;       // SHA-1 from data index, "mutable" for mutable files
+        quint64 size;
+        bool native;
+        QString repository; // Custom library repository from version index
+        QStringList excludes; // Entries of native library not to be extracted
+    };
+
+    InstallPlan();
+
+    bool resolve(QString client, QString version, Platforms platforms = CurrentPlatform);
+
+    Error getError();
+    QString getErrorString();
+
+    QString getVersion();
+    QString getAssetsId();
+    QString getMainClass();
+    QString getMinecraftArguments();
+    int getMemoryHint(); // Recommended heap size in MiB from data index, 0 if not specified
+
+    bool hasDataIndex();
+    bool hasAssetsIndex();
+
+    QList<Artifact> getArtifacts();
+    QList<Artifact> getArtifacts(Kind kind);
+
+private:
+    QString client;
+    QString version;
+    Platforms platforms;
+
+    Error error;
+    QString errorString;
+
+    QString assetsId;
+    QString mainClass;
+    QString minecraftArguments;
+    int memoryHint;
+    bool dataIndexFound;
+    bool assetsIndexFound;
+
+    QList<Artifact> artifacts;
+
+    QString getCacheFileName();
+    QByteArray makeKey(const QByteArray& versionData, const QByteArray& dataData, const QByteArray& assetsData);
+    bool loadCache(const QByteArray& versionData, const QByteArray& dataData);
+    void saveCache(const QByteArray& key);
+    bool build(const GameIndex::VersionIndex& versionIndex, const QByteArray& dataData, const QByteArray& assetsData);
+
+    void addLibrary(QString suffix, const GameIndex::Library& library, const GameIndex::FileIndex& libIndex, bool native);
+
+};
+
+#endif // INSTALLPLAN_H
@@ -0,0 +1,138 @@
+#include "integrityscrubber.h"
+
+#include "settings.h"
+#include "resourcecontrols.h"
+
+#include <QCryptographicHash>
+
+IntegrityScrubber::IntegrityScrubber(QObject *parent) :
+    QThread(parent)
+{
+    cache = FingerprintCache::instance();
+
+    rateLimit = 4 * 1024 * 1024; // 4 MiB/s by default
+    paused = false;
+    stopped = false;
+    bytesRead = 0;
+}
+
+IntegrityScrubber::~IntegrityScrubber() {
+    stop();
+    wait();
+}
+
+void IntegrityScrubber::setTargets(QStringList dirs, QStringList files) {
+    targetDirs = dirs;
+    targetFiles = files;
+}
+
+void IntegrityScrubber::setRateLimit(qint64 bytesPerSecond) {
+    rateLimit = qMax(bytesPerSecond, qint64(1));
+}
+
+void IntegrityScrubber::pause() {
+    QMutexLocker locker(&mutex);
+    paused = true;
+    stateChanged.wakeAll();
+}
+
+void IntegrityScrubber::resume() {
+    QMutexLocker locker(&mutex);
+    paused = false;
+    stateChanged.wakeAll();
+}
+
+void IntegrityScrubber::stop() {
+    QMutexLocker locker(&mutex);
+    stopped = true;
+    stateChanged.wakeAll();
+}
+
+// Sleep for rate limit delay and block while paused. Returns false if stopped
+bool IntegrityScrubber::waitForTurn(qint64 delay) {
+
+    QMutexLocker locker(&mutex);
+
+    if (delay > 0 && !paused && !stopped) {
+        stateChanged.wait(&mutex, delay);
+    }
+
+    if (paused && !stopped) {
+        while (paused && !stopped) stateChanged.wait(&mutex);
+
+        // Do not make I/O burst after long pause
+        rateTimer.restart();
+        bytesRead = 0;
+    }
+
+    return !stopped;
+}
+
+bool IntegrityScrubber::scrubFile(QString fileName, bool* rehashed) {
+
+    *rehashed = false;
+
+    // Already verified and not changed since that
+    if (!cache->getFreshHash(fileName).isEmpty()) return true;
+
+    QFileInfo info(fileName);
+    qint64 size = info.size();
+    QDateTime mtime = info.lastModified();
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) return true;
+
+    QCryptographicHash sha1(QCryptographicHash::Sha1);
+    char buffer[64 * 1024];
+    qint64 count;
+
+    while ((count = file.read(buffer, sizeof(buffer))) > 0) {
+        sha1.addData(buffer, int(count));
+        bytesRead += count;
+
+        if (!waitForTurn(bytesRead * 1000 / rateLimit - rateTimer.elapsed())) return false;
+    }
+    file.close();
+
+    // Skip record if file was modified during hashing
+    QFileInfo current(fileName);
+    if (current.size() == size && current.lastModified() == mtime) {
+        cache->record(fileName, QString(sha1.result().toHex()));
+        *rehashed = true;
+    }
+
+    return true;
+}
+
+void IntegrityScrubber::run() {
+
+    // Game and user programs should not wait for verification
+    if (Settings::instance()->loadIdleIoState()) ResourceControls::setIdleIoPriority();
+
+    int checked = 0, rehashed = 0;
+    bool hashed;
+
+    rateTimer.start();
+    bytesRead = 0;
+
+    foreach (QString fileName, targetFiles) {
+        if (!waitForTurn(0)) return;
+        if (!scrubFile(fileName, &hashed)) return;
+
+        checked++;
+        if (hashed) rehashed++;
+    }
+
+    foreach (QString dir, targetDirs) {
+        QDirIterator it(dir, QDir::Files, QDirIterator::Subdirectories);
+        while (it.hasNext()) {
+            if (!waitForTurn(0)) return;
+            if (!scrubFile(it.next(), &hashed)) return;
+
+            checked++;
+            if (hashed) rehashed++;
+        }
+    }
+
+    emit scrubFinished(checked, rehashed);
+}
@@ -0,0 +1,50 @@
+#ifndef INTEGRITYSCRUBBER_H
+#define INTEGRITYSCRUBBER_H
+
+#include <QtCore>
+
+#include "fingerprintcache.h"
+
+// Low priority background job, that walks installed game files
+// and records their hashes to the fingerprint cache
+class IntegrityScrubber : public QThread
+{
+    Q_OBJECT
+public:
+    explicit IntegrityScrubber(QObject *parent = 0);
+    ~IntegrityScrubber();
+
+    void setTargets(QStringList dirs, QStringList files);
+    void setRateLimit(qint64 bytesPerSecond);
+
+    void pause();
+    void resume();
+    void stop();
+
+protected:
+    void run();
+
+private:
+    FingerprintCache* cache;
+
+    QStringList targetDirs;
+    QStringList targetFiles;
+    qint64 rateLimit;
+
+    QMutex mutex;
+    QWaitCondition stateChanged;
+    bool paused;
+    bool stopped;
+
+    QElapsedTimer rateTimer;
+    qint64 bytesRead;
+
+    bool scrubFile(QString fileName, bool* rehashed);
+    bool waitForTurn(qint64 delay);
+
+signals:
+    void scrubFinished(int checked, int rehashed);
+
+};
+
+#endif // INTEGRITYSCRUBBER_H
@@ -0,0 +1,373 @@
+#include "javaregistry.h"
+#include "settings.h"
+
+#include <QSaveFile>
+
+// Probe must not hang the launcher on broken runtimes
+static const int probeTimeout = 15000;
+
+// VM flags used by launcher features
+static const char* interestingFlags[] = {
+    "ArchiveClassesAtExit", "AutoCreateSharedArchive", "UseG1GC", "UseZGC",
+    "UseShenandoahGC", "UseStringDeduplication", 0
+};
+
+JavaRegistry* JavaRegistry::myInstance = 0;
+JavaRegistry* JavaRegistry::instance() {
+    if (myInstance == 0) myInstance = new JavaRegistry();
+    return myInstance;
+}
+
+JavaRegistry::JavaRegistry(QObject *parent) :
+    QObject(parent)
+{
+    logger = Logger::logger();
+    cacheFileName = Settings::instance()->getBaseDir() + "/java_runtimes.json";
+    discovered = false;
+
+    load();
+}
+
+QString JavaRegistry::resolvePath(QString java) {
+
+    QString path = QFileInfo(java).isAbsolute() ? java : QStandardPaths::findExecutable(java);
+    if (path.isEmpty()) return "";
+
+    return QFileInfo(path).canonicalFilePath();
+}
+
+QStringList JavaRegistry::findBinaries() {
+
+    bool windows = (Settings::instance()->getOsName() == "windows");
+    QString binary = windows ? "java.exe" : "java";
+
+    QStringList candidates;
+    candidates << "java";
+
+    QString javaHome = QProcessEnvironment::systemEnvironment().value("JAVA_HOME");
+    if (!javaHome.isEmpty()) candidates << javaHome + "/bin/" + binary;
+
+    // Standard JVM locations of Linux distributions, vendors and SDK managers
+    QStringList jvmDirs;
+    if (!windows) {
+        jvmDirs << "/usr/lib/jvm" << "/usr/lib64/jvm" << "/usr/java" << "/opt" << "/opt/java"
+                << QDir::homePath() + "/.jdks" << QDir::homePath() + "/.sdkman/candidates/java";
+    }
+
+    foreach (QString jvmDir, jvmDirs) {
+        QDir dir(jvmDir);
+        foreach (QString name, dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+            QString path = dir.absoluteFilePath(name) + "/bin/" + binary;
+            if (QFile::exists(path)) candidates << path;
+        }
+    }
+
+    // Symlinks like default-java point to the same runtimes
+    QStringList binaries;
+    foreach (QString candidate, candidates) {
+        QString path = resolvePath(candidate);
+        if (!path.isEmpty() && !binaries.contains(path)) binaries << path;
+    }
+
+    return binaries;
+}
+
+bool JavaRegistry::probe(QString path, Runtime* runtime) {
+
+    QFileInfo info(path);
+    runtime->path = path;
+    runtime->size = info.size();
+    runtime->mtime = info.lastModified().toMSecsSinceEpoch();
+    runtime->probed = true;
+    runtime->valid = false;
+    runtime->major = 0;
+    runtime->bits = 0;
+    runtime->version.clear();
+    runtime->vendor.clear();
+    runtime->flags.clear();
+
+    logger->append("JavaRegistry", "Probing " + path + "\n");
+
+    // Properties and flags at once, single process per runtime
+    QProcess process;
+    process.setProcessChannelMode(QProcess::MergedChannels);
+    process.start(path, QStringList() << "-XshowSettings:properties" << "-XX:+PrintFlagsFinal" << "-version");
+
+    if (!process.waitForStarted(probeTimeout) || !process.waitForFinished(probeTimeout)) {
+        logger->append("JavaRegistry", "Error: can't run " + path + "\n");
+        process.kill();
+        process.waitForFinished();
+        return false;
+    }
+
+    QString output = QString::fromLocal8Bit(process.readAll());
+    foreach (QString line, output.split('\n')) {
+        QStringList tokens = line.simplified().split(' ');
+
+        // Property: "java.version = 1.8.0_292"
+        if (tokens.size() >= 3 && tokens[1] == "=" && tokens[0].contains('.')) {
+            QString value = QStringList(tokens.mid(2)).join(' ');
+            if (tokens[0] == "java.version") runtime->version = value;
+            if (tokens[0] == "java.vendor") runtime->vendor = value;
+            if (tokens[0] == "sun.arch.data.model") runtime->bits = value.toInt();
+            continue;
+        }
+
+        // Flag: "bool UseG1GC = false {product} {default}"
+        if (tokens.size() >= 4 && tokens[2] == "=") {
+            for (int i = 0; interestingFlags[i] != 0; i++) {
+                if (tokens[1] == interestingFlags[i]) runtime->flags << tokens[1];
+            }
+        }
+    }
+
+    if (runtime->version.isEmpty()) {
+        logger->append("JavaRegistry", "Error: can't read version of " + path + "\n");
+        return false;
+    }
+
+    QStringList versionParts = runtime->version.split(QRegExp("[._+-]"));
+    runtime->major = versionParts[0].toInt();
+    if (runtime->major == 1 && versionParts.size() > 1) runtime->major = versionParts[1].toInt();
+
+    runtime->valid = true;
+    logger->append("JavaRegistry", "Found " + describe(*runtime) + "\n");
+    return true;
+}
+
+void JavaRegistry::refresh() {
+
+    QMutexLocker refreshLocker(&refreshMutex);
+
+    QStringList binaries = findBinaries();
+    bool modified = false;
+
+    foreach (QString path, binaries) {
+        QFileInfo info(path);
+        {
+            QMutexLocker locker(&mutex);
+            QHash<QString, Runtime>::const_iterator it = runtimes.constFind(path);
+            if (it != runtimes.constEnd() && it->size == info.size()
+                    && it->mtime == info.lastModified().toMSecsSinceEpoch()) continue;
+        }
+
+        // New or updated runtime, invalid ones are cached too
+        Runtime runtime;
+        probe(path, &runtime);
+
+        QMutexLocker locker(&mutex);
+        runtimes[path] = runtime;
+        modified = true;
+    }
+
+    // Removed runtimes
+    {
+        QMutexLocker locker(&mutex);
+        foreach (QString path, runtimes.keys()) {
+            if (!QFile::exists(path)) {
+                runtimes.remove(path);
+                modified = true;
+            }
+        }
+        discovered = true;
+    }
+
+    if (modified) save();
+}
+
+QList<JavaRegistry::Runtime> JavaRegistry::getRuntimes() {
+
+    {
+        QMutexLocker locker(&mutex);
+        if (discovered) return runtimes.values();
+    }
+
+    refresh();
+
+    QMutexLocker locker(&mutex);
+    return runtimes.values();
+}
+
+QList<JavaRegistry::Runtime> JavaRegistry::getCachedRuntimes() {
+    QMutexLocker locker(&mutex);
+    return runtimes.values();
+}
+
+// Fills runtime from cache if binary is not changed, or leaves it not probed
+bool JavaRegistry::findCached(QString java, Runtime* runtime) {
+
+    runtime->probed = false;
+    runtime->valid = false;
+    runtime->major = 0;
+    runtime->bits = 0;
+    runtime->size = 0;
+    runtime->mtime = 0;
+
+    QString path = resolvePath(java);
+    runtime->path = path.isEmpty() ? java : path;
+    if (path.isEmpty()) return false;
+
+    QFileInfo info(path);
+    QMutexLocker locker(&mutex);
+
+    QHash<QString, Runtime>::const_iterator it = runtimes.constFind(path);
+    if (it == runtimes.constEnd() || it->size != info.size()
+            || it->mtime != info.lastModified().toMSecsSinceEpoch()) return false;
+
+    *runtime = *it;
+    return true;
+}
+
+JavaRegistry::Runtime JavaRegistry::getCachedRuntime(QString java) {
+    Runtime runtime;
+    findCached(java, &runtime);
+    return runtime;
+}
+
+JavaRegistry::Runtime JavaRegistry::getRuntime(QString java) {
+
+    Runtime runtime;
+    if (findCached(java, &runtime)) return runtime;
+
+    // Missing binary is known not working without probe
+    QString path = runtime.path;
+    if (!QFile::exists(path)) {
+        runtime.probed = true;
+        return runtime;
+    }
+
+    QMutexLocker refreshLocker(&refreshMutex);
+    probe(path, &runtime);
+    {
+        QMutexLocker locker(&mutex);
+        runtimes[path] = runtime;
+    }
+    save();
+
+    return runtime;
+}
+
+QString JavaRegistry::selectJava(int requiredMajor) {
+    return selectFrom(getRuntimes(), requiredMajor);
+}
+
+QString JavaRegistry::selectCachedJava(int requiredMajor) {
+    return selectFrom(getCachedRuntimes(), requiredMajor);
+}
+
+QString JavaRegistry::selectFrom(const QList<Runtime>& known, int requiredMajor) {
+
+    int wordSize = Settings::instance()->getWordSize().toInt();
+
+    // Exact major version first (old clients break on newer Java),
+    // then the closest newer one; native word size is preferred
+    const Runtime* best = 0;
+
+    for (int i = 0; i < known.size(); i++) {
+        const Runtime& runtime = known.at(i);
+        if (!runtime.valid || runtime.major < requiredMajor) continue;
+
+        if (best == 0) {
+            best = &runtime;
+            continue;
+        }
+
+        bool exact = (runtime.major == requiredMajor), bestExact = (best->major == requiredMajor);
+        bool native = (runtime.bits == wordSize), bestNative = (best->bits == wordSize);
+
+        if (exact != bestExact) {
+            if (exact) best = &runtime;
+        } else if (runtime.major != best->major) {
+            if (runtime.major < best->major) best = &runtime;
+        } else if (native != bestNative) {
+            if (native) best = &runtime;
+        }
+    }
+
+    if (best == 0) {
+        logger->append("JavaRegistry", "No Java " + QString::number(requiredMajor) + "+ found, using java from PATH\n");
+        return "java";
+    }
+
+    logger->append("JavaRegistry", "Selected for Java " + QString::number(requiredMajor) + ": " + describe(*best) + "\n");
+    return best->path;
+}
+
+QString JavaRegistry::describe(const Runtime& runtime) {
+
+    if (!runtime.probed) return runtime.path + ": not probed yet";
+    if (!runtime.valid) return runtime.path + ": not a working Java runtime";
+
+    return runtime.path + ": " + runtime.version + " (" + runtime.vendor + ", "
+            + QString::number(runtime.bits) + " bit), flags: " + runtime.flags.join(", ");
+}
+
+void JavaRegistry::load() {
+
+    QFile cacheFile(cacheFileName);
+    if (!cacheFile.open(QIODevice::ReadOnly)) return;
+
+    QJsonParseError error;
+    QJsonDocument json = QJsonDocument::fromJson(cacheFile.readAll(), &error);
+    cacheFile.close();
+
+    if (error.error != QJsonParseError::NoError) {
+        logger->append("JavaRegistry", "Error: can't parse cache, dropping it\n");
+        return;
+    }
+
+    QMutexLocker locker(&mutex);
+    runtimes.clear();
+
+    QJsonObject entries = json.object()["runtimes"].toObject();
+    for (QJsonObject::const_iterator it = entries.constBegin(); it != entries.constEnd(); ++it) {
+        QJsonObject entry = it.value().toObject();
+
+        Runtime runtime;
+        runtime.path = it.key();
+        runtime.size = qint64(entry["size"].toDouble());
+        runtime.mtime = qint64(entry["mtime"].toDouble());
+        runtime.probed = true;
+        runtime.valid = entry["valid"].toBool();
+        runtime.version = entry["version"].toString();
+        runtime.major = entry["major"].toInt();
+        runtime.vendor = entry["vendor"].toString();
+        runtime.bits = entry["bits"].toInt();
+        foreach (QJsonValue flag, entry["flags"].toArray()) runtime.flags << flag.toString();
+
+        runtimes.insert(runtime.path, runtime);
+    }
+}
+
+void JavaRegistry::save() {
+
+    QJsonObject entries;
+    {
+        QMutexLocker locker(&mutex);
+        foreach (const Runtime& runtime, runtimes) {
+            QJsonObject entry;
+            entry["size"] = double(runtime.size);
+            entry["mtime"] = double(runtime.mtime);
+            entry["valid"] = runtime.valid;
+            entry["version"] = runtime.version;
+            entry["major"] = runtime.major;
+            entry["vendor"] = runtime.vendor;
+            entry["bits"] = runtime.bits;
+            entry["flags"] = QJsonArray::fromStringList(runtime.flags);
+            entries[runtime.path] = entry;
+        }
+    }
+
+    QJsonObject root;
+    root["runtimes"] = entries;
+
+    QSaveFile cacheFile(cacheFileName);
+    if (cacheFile.open(QIODevice::WriteOnly)) {
+        cacheFile.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+        if (!cacheFile.commit()) {
+            logger->append("JavaRegistry", "Error: save cache: " + cacheFile.errorString() + "\n");
+        }
+    } else {
+        logger->append("JavaRegistry", "Error: save cache: " + cacheFile.errorString() + "\n");
+    }
+}
@@ -0,0 +1,75 @@
+#ifndef JAVAREGISTRY_H
+#define JAVAREGISTRY_H
+
+#include <QtCore>
+
+#include "logger.h"
+
+// Installed Java runtimes. Each binary is probed once, results are cached
+// in java_runtimes.json and reused while binary size and mtime are the same.
+class JavaRegistry : public QObject
+{
+    Q_OBJECT
+public:
+    static JavaRegistry* instance();
+
+    struct Runtime {
+        QString path;       // Canonical path of java binary
+        qint64 size;
+        qint64 mtime;
+        bool probed;        // False if runtime is not in cache yet
+        bool valid;         // Probe succeeded
+        QString version;    // java.version
+        int major;          // 8 for 1.8.0_x, 17 for 17.0.x
+        QString vendor;
+        int bits;
+        QStringList flags;  // Supported VM flags from the interesting ones
+    };
+
+private:
+    static JavaRegistry* myInstance;
+
+    explicit JavaRegistry(QObject *parent = 0);
+
+    QString cacheFileName;
+    QHash<QString, Runtime> runtimes;
+    QMutex mutex;
+    QMutex refreshMutex;
+    bool discovered;
+
+    Logger* logger;
+
+    JavaRegistry& operator=(JavaRegistry const&);
+    JavaRegistry(JavaRegistry const&);
+
+    QStringList findBinaries();
+    bool probe(QString path, Runtime* runtime);
+    QString resolvePath(QString java);
+    bool findCached(QString java, Runtime* runtime);
+    QString selectFrom(const QList<Runtime>& known, int requiredMajor);
+
+    void load();
+    void save();
+
+public:
+    // Discovers runtimes in standard locations, probes only new or changed ones
+    void refresh();
+
+    // Known runtimes, discovers them on first call
+    QList<Runtime> getRuntimes();
+
+    // Runtime of specified binary ("java" is searched in PATH), probed if not cached
+    Runtime getRuntime(QString java);
+
+    // Best runtime for game requiring Java major version, "java" if nothing found
+    QString selectJava(int requiredMajor);
+
+    // Same from cache only: never start probes or wait for refresh, safe for GUI thread
+    QList<Runtime> getCachedRuntimes();
+    Runtime getCachedRuntime(QString java);
+    QString selectCachedJava(int requiredMajor);
+
+    static QString describe(const Runtime& runtime);
+};
+
+#endif // JAVAREGISTRY_H
@@ -0,0 +1,127 @@
+#include "jsonwriter.h"
+
+static const int bufferSize = 64 * 1024;
+
+JsonWriter::JsonWriter(QIODevice* device) {
+    this->device = device;
+    error = false;
+    buffer.reserve(bufferSize + 1024);
+}
+
+void JsonWriter::beginValue(const QString* key) {
+
+    if (counts.isEmpty()) return;
+
+    if (counts.last() != 0) buffer.append(',');
+    buffer.append('\n');
+    buffer.append(QByteArray(counts.size() * 4, ' '));
+    counts.last()++;
+
+    if (key != 0) {
+        appendString(*key);
+        buffer.append(": ");
+    }
+}
+
+void JsonWriter::beginObject() {
+    beginValue(0);
+    buffer.append('{');
+    counts.append(0);
+}
+
+void JsonWriter::beginObject(QString key) {
+    beginValue(&key);
+    buffer.append('{');
+    counts.append(0);
+}
+
+void JsonWriter::endObject() {
+    endLevel('}');
+}
+
+void JsonWriter::beginArray() {
+    beginValue(0);
+    buffer.append('[');
+    counts.append(0);
+}
+
+void JsonWriter::beginArray(QString key) {
+    beginValue(&key);
+    buffer.append('[');
+    counts.append(0);
+}
+
+void JsonWriter::endArray() {
+    endLevel(']');
+}
+
+void JsonWriter::endLevel(char bracket) {
+
+    int count = counts.takeLast();
+    if (count != 0) {
+        buffer.append('\n');
+        buffer.append(QByteArray(counts.size() * 4, ' '));
+    }
+    buffer.append(bracket);
+
+    flush();
+}
+
+void JsonWriter::writeString(QString value) {
+    beginValue(0);
+    appendString(value);
+    flush();
+}
+
+void JsonWriter::writeString(QString key, QString value) {
+    beginValue(&key);
+    appendString(value);
+    flush();
+}
+
+void JsonWriter::writeNumber(QString key, qint64 value) {
+    beginValue(&key);
+    buffer.append(QByteArray::number(value));
+    flush();
+}
+
+void JsonWriter::appendString(const QString& value) {
+
+    buffer.append('"');
+
+    const QByteArray utf8 = value.toUtf8();
+    for (int i = 0; i < utf8.size(); i++) {
+        char c = utf8.at(i);
+        switch (c) {
+            case '"':  buffer.append("\\\""); break;
+            case '\\': buffer.append("\\\\"); break;
+            case '\b': buffer.append("\\b"); break;
+            case '\f': buffer.append("\\f"); break;
+            case '\n': buffer.append("\\n"); break;
+            case '\r': buffer.append("\\r"); break;
+            case '\t': buffer.append("\\t"); break;
+            default:
+                if (uchar(c) < 0x20) {
+                    buffer.append("\\u00").append(QByteArray::number(uchar(c), 16).rightJustified(2, '0'));
+                } else {
+                    buffer.append(c);
+                }
+        }
+    }
+
+    buffer.append('"');
+}
+
+void JsonWriter::flush(bool force) {
+
+    if (buffer.size() < bufferSize && !force) return;
+
+    if (!error && device->write(buffer) != buffer.size()) error = true;
+    buffer.resize(0); // Reserved capacity is kept
+}
+
+bool JsonWriter::finish() {
+    buffer.append('\n');
+    flush(true);
+    return !error;
+}
@@ -0,0 +1,41 @@
+#ifndef JSONWRITER_H
+#define JSONWRITER_H
+
+#include <QtCore>
+
+// Streaming JSON writer with the same indented layout as QJsonDocument::toJson().
+// Output is buffered in small chunks, so the writer itself does not keep the document.
+// Writer does not sort keys, callers write them in sorted order.
+class JsonWriter
+{
+public:
+    explicit JsonWriter(QIODevice* device);
+
+    // Values with key are written inside objects, without key inside arrays and as root
+    void beginObject();
+    void beginObject(QString key);
+    void endObject();
+    void beginArray();
+    void beginArray(QString key);
+    void endArray();
+
+    void writeString(QString value);
+    void writeString(QString key, QString value);
+    void writeNumber(QString key, qint64 value);
+
+    // Writes closing newline and flushes buffer, returns false on write error
+    bool finish();
+
+private:
+    QIODevice* device;
+    QByteArray buffer;
+    QVector<int> counts; // Values written on each open level
+    bool error;
+
+    void beginValue(const QString* key);
+    void endLevel(char bracket);
+    void appendString(const QString& value);
+    void flush(bool force = false);
+};
+
+#endif // JSONWRITER_H
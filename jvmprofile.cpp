@@ -0,0 +1,120 @@
+#include "jvmprofile.h"
+#include "logger.h"
+
+// Heap size if version has no memory hint
+static const int defaultHeap = 2048;
+static const int minimalHeap = 512;
+
+// Address space of 32-bit JVM can't hold larger heap
+static const int maxHeap32 = 1024;
+
+// ZGC needs more memory than G1 to pay off
+static const int zgcMinimalHeap = 4096;
+
+// Returns MemTotal and MemAvailable in MiB, zeroes if unknown
+static void readMemoryInfo(int* total, int* available) {
+
+    *total = 0;
+    *available = 0;
+
+    QFile meminfo("/proc/meminfo");
+    if (!meminfo.open(QIODevice::ReadOnly)) return;
+
+    // Lines are like "MemTotal:       16307224 kB"
+    foreach (QByteArray line, meminfo.readAll().split('\n')) {
+        QList<QByteArray> tokens = line.simplified().split(' ');
+        if (tokens.size() < 2) continue;
+
+        if (tokens[0] == "MemTotal:") *total = int(tokens[1].toLongLong() / 1024);
+        if (tokens[0] == "MemAvailable:") *available = int(tokens[1].toLongLong() / 1024);
+    }
+    meminfo.close();
+}
+
+static bool hasUserOption(const QStringList& userArgs, QString prefix) {
+    foreach (QString arg, userArgs) {
+        if (arg.startsWith(prefix)) return true;
+    }
+    return false;
+}
+
+// Options like -XX:+UseParallelGC
+static bool hasUserCollector(const QStringList& userArgs) {
+    QRegExp collector("-XX:[+-]Use\\w*GC");
+    foreach (QString arg, userArgs) {
+        if (collector.exactMatch(arg)) return true;
+    }
+    return false;
+}
+
+namespace JvmProfile {
+
+QStringList makeArguments(const JavaRegistry::Runtime& runtime, int memoryHint, QStringList userArgs) {
+
+    Logger* logger = Logger::logger();
+
+    int total, available;
+    readMemoryInfo(&total, &available);
+    int cores = QThread::idealThreadCount();
+
+    logger->append("JvmProfile", "System: " + QString::number(total) + " MiB total, "
+                   + QString::number(available) + " MiB available, " + QString::number(cores) + " cores, java "
+                   + (runtime.valid ? runtime.version : "unknown") + ", memory hint "
+                   + QString::number(memoryHint) + " MiB\n");
+
+    // Heap: hint of version, limited by half of RAM to leave room for OS and native memory
+    int heap = (memoryHint > 0) ? memoryHint : defaultHeap;
+    if (total > 0) heap = qMin(heap, total / 2);
+    if (runtime.bits == 32) heap = qMin(heap, maxHeap32);
+    heap = qMax(heap, minimalHeap);
+
+    // Initial heap is not committed at once, but avoids early resizing pauses
+    int initialHeap = heap / 2;
+    if (available > 0) initialHeap = qMin(initialHeap, qMax(minimalHeap, available / 2));
+    initialHeap = qMin(qMax(initialHeap, minimalHeap), heap);
+
+    QStringList args;
+    if (!hasUserOption(userArgs, "-Xmx")) args << "-Xmx" + QString::number(heap) + "M";
+    if (!hasUserOption(userArgs, "-Xms")) args << "-Xms" + QString::number(initialHeap) + "M";
+
+    // Collector is chosen only for probed runtime and if user has not chosen one
+    if (!runtime.valid || hasUserCollector(userArgs)) {
+        logger->append("JvmProfile", "Profile: " + args.join(' ') + "\n");
+        return args;
+    }
+
+    QStringList gcArgs;
+    if (runtime.major >= 21 && runtime.flags.contains("UseZGC") && heap >= zgcMinimalHeap) {
+
+        // Generational mode is default since 23 and obsolete after
+        gcArgs << "-XX:+UseZGC";
+        if (runtime.major < 23) gcArgs << "-XX:+ZGenerational";
+
+    } else if (runtime.flags.contains("UseG1GC")) {
+
+        // Short pauses matter more than throughput for the game
+        gcArgs << "-XX:+UseG1GC" << "-XX:MaxGCPauseMillis=50" << "-XX:+ParallelRefProcEnabled";
+
+        // Keep a core for render thread on small systems
+        if (cores > 1 && cores <= 8) gcArgs << "-XX:ParallelGCThreads=" + QString::number(cores - 1);
+    }
+
+    // Mods often call System.gc() which means full collection
+    if (!gcArgs.isEmpty()) gcArgs << "-XX:+DisableExplicitGC";
+
+    foreach (QString gcArg, gcArgs) {
+        // -XX:MaxGCPauseMillis=50 is overridden by user -XX:MaxGCPauseMillis=100
+        QString name = gcArg.section('=', 0, 0).mid(4);
+        if (name.startsWith('+') || name.startsWith('-')) name = name.mid(1);
+
+        if (!hasUserOption(userArgs, "-XX:" + name) && !hasUserOption(userArgs, "-XX:+" + name)
+                && !hasUserOption(userArgs, "-XX:-" + name)) {
+            args << gcArg;
+        }
+    }
+
+    logger->append("JvmProfile", "Profile: " + args.join(' ') + "\n");
+    return args;
+}
+
+}
@@ -0,0 +1,17 @@
+#ifndef JVMPROFILE_H
+#define JVMPROFILE_H
+
+#include <QtCore>
+
+#include "javaregistry.h"
+
+// Heap size and garbage collector flags for the game, computed from
+// system memory, core count, Java runtime and memory hint of the version.
+namespace JvmProfile {
+
+// Returns arguments for java, options already given by user are skipped
+QStringList makeArguments(const JavaRegistry::Runtime& runtime, int memoryHint, QStringList userArgs);
+
+}
+
+#endif // JVMPROFILE_H
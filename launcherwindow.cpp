@@ -14,12 +14,23 @@
 
 #include "settings.h"
 #include "util.h"
+#include "fingerprintcache.h"
+#include "storewatcher.h"
+#include "launchplan.h"
+#include "nativescache.h"
+#include "versionscatalog.h"
+#include "indexcache.h"
+#include "gameindex.h"
+#include "javaregistry.h"
+#include "jvmprofile.h"
+#include "authsession.h"
 
 #include <QtGui>
 #include <QDesktopWidget>
 #include <QMessageBox>
 #include <QShortcut>
 #include <QWebFrame>
+#include <QtConcurrent>
 
 LauncherWindow::LauncherWindow(QWidget *parent) :
     QMainWindow(parent),
@@ -110,6 +121,40 @@ LauncherWindow::LauncherWindow(QWidget *parent) :
 
     connect(ui->playButton, SIGNAL(clicked()), this, SLOT(playButtonClicked()));
 
+    // Track changes in game store to avoid full checks on launch
+    QStringList storeRoots;
+    storeRoots << settings->getLibsDir() << settings->getAssetsDir() + "/objects";
+
+    QStringList clientDirs = QDir(settings->getBaseDir()).entryList(QStringList() << "client_*", QDir::Dirs);
+    foreach (QString clientDir, clientDirs) {
+        storeRoots << settings->getBaseDir() + "/" + clientDir + "/versions"
+                   << settings->getBaseDir() + "/" + clientDir + "/prefixes";
+    }
+
+    StoreWatcher::instance()->start(storeRoots);
+    connect(StoreWatcher::instance(), SIGNAL(rescanNeeded()), this, SLOT(storeRescanNeeded()));
+
+    // Probe new or updated Java runtimes in background
+    javaRefresh = QtConcurrent::run(JavaRegistry::instance(), &JavaRegistry::refresh);
+
+    // Setup background integrity scrubber (started when news page are shown)
+    scrubber = new IntegrityScrubber(this);
+    session = 0;
+    launching = false;
+    closePending = false;
+    connect(scrubber, SIGNAL(scrubFinished(int,int)), this, SLOT(scrubFinished(int,int)));
+
+    // Setup speculative launch preparation for the active client
+    prewarmer = new Prewarmer(this);
+    prewarmPending = false;
+    prewarmHits = 0;
+    prewarmPartialHits = 0;
+    prewarmMisses = 0;
+    connect(prewarmer, SIGNAL(finished()), this, SLOT(prewarmFinished()));
+    connect(ui->clientCombo, SIGNAL(activated(int)), this, SLOT(startPrewarm()));
+    connect(ui->playOffline, SIGNAL(triggered()), this, SLOT(startPrewarm()));
+    QTimer::singleShot(0, this, SLOT(startPrewarm()));
+
     logger->append(this->objectName(), "Launcher window opened\n");
 
     if (ui->clientCombo->count() == 0) {
@@ -121,13 +166,27 @@ LauncherWindow::LauncherWindow(QWidget *parent) :
 }
 
 void LauncherWindow::closeEvent (QCloseEvent* event) {
+
+    // Launch is still using scrubber and caches, window is closed after it
+    if (launching) {
+        logger->append(this->objectName(), "Launcher window close is deferred until launch is done\n");
+        closePending = true;
+        event->ignore();
+        return;
+    }
+
     logger->append(this->objectName(), "Launcher window closed\n");
     storeParameters();
+
+    scrubber->stop();
+    scrubber->wait();
+    FingerprintCache::instance()->save();
+    StoreWatcher::instance()->save();
     event->accept();
 }
 
 void LauncherWindow::keyPressEvent(QKeyEvent* pe) {
-    if(pe->key() == Qt::Key_Return) playButtonClicked();
+    if(pe->key() == Qt::Key_Return && !launching) playButtonClicked();
     pe->accept();
 }
 
@@ -182,6 +241,7 @@ void LauncherWindow::showSettingsDialog() {
     delete d;
 
     ui->clientCombo->setCurrentIndex(settings->loadActiveClientId());
+    startPrewarm();
 }
 
 void LauncherWindow::showSkinLoadDialog() {
@@ -214,11 +274,121 @@ void LauncherWindow::offlineModeChanged() {
 
 void LauncherWindow::showUpdateDialog(QString message) {
 
+    scrubber->pause();
+
     UpdateDialog* d = new UpdateDialog(message, this);
     d->exec();
     delete d;
 
     ui->clientCombo->setCurrentIndex(settings->loadActiveClientId());
+
+    // Files may be changed by update, so scrub them again
+    scrubbedKey.clear();
+    scrubber->resume();
+    startScrubber();
+    startPrewarm();
+}
+
+Prewarmer::Target LauncherWindow::makePrewarmTarget() {
+
+    Prewarmer::Target target;
+    target.client = settings->getClientStrId(settings->loadActiveClientId());
+    target.version = settings->loadClientVersion();
+    target.java = settings->loadClientJavaState() ? settings->loadClientJava() : ""; // Selected by registry
+    target.online = !ui->playOffline->isChecked();
+    target.versionsUrl = settings->getVersionsUrl();
+
+    return target;
+}
+
+void LauncherWindow::startPrewarm() {
+
+    // Game is running or launching now
+    if (session != 0 || !ui->centralWidget->isEnabled()) return;
+    if (ui->clientCombo->count() == 0) return;
+
+    Prewarmer::Target target = makePrewarmTarget();
+    QString key = Prewarmer::makeKey(target);
+
+    // Restart with new target when current run is canceled
+    if (prewarmer->isRunning()) {
+        if (prewarmer->getKey() != key) {
+            prewarmer->cancel();
+            prewarmPending = true;
+        }
+        return;
+    }
+
+    if (prewarmer->getKey() == key && prewarmer->isFresh()) return;
+
+    prewarmer->setTarget(target);
+    prewarmer->start(QThread::LowPriority);
+}
+
+void LauncherWindow::prewarmFinished() {
+
+    if (prewarmPending) {
+        prewarmPending = false;
+        startPrewarm();
+    }
+}
+
+void LauncherWindow::startScrubber() {
+
+    if (scrubber->isRunning()) return;
+
+    QString version = settings->loadClientVersion();
+    QString key = settings->getClientStrId(settings->loadActiveClientId()) + "/" + version;
+    if (key == scrubbedKey) return;
+
+    QStringList dirs, files;
+    dirs << settings->getLibsDir() << settings->getAssetsDir() + "/objects";
+
+    // 'latest' version is not resolved yet, so scrub all installed versions
+    QStringList versions;
+    if (version == "latest") {
+        versions = QDir(settings->getVersionsDir()).entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    } else {
+        versions << version;
+    }
+
+    foreach (QString ver, versions) {
+        files << settings->getVersionsDir() + "/" + ver + "/" + ver + ".jar";
+
+        // Scrub only files from installed index (skip saves, screenshots, etc)
+        QFile installedDataFile(settings->getClientPrefix(ver) + "/installed_data.json");
+        if (installedDataFile.open(QIODevice::ReadOnly)) {
+            GameIndex::DataIndex installedIndex = IndexCache::parseData(
+                        settings->getVersionsDir() + "/" + ver + "/installed_data.json", installedDataFile.readAll());
+            installedDataFile.close();
+
+            foreach (const GameIndex::Entry& file, installedIndex.files.getEntries()) {
+                files << settings->getClientPrefix(ver) + "/" + file.path;
+            }
+        }
+    }
+
+    logger->append(this->objectName(), "Starting integrity scrubber for " + key + "\n");
+
+    scrubbingKey = key;
+    scrubber->setTargets(dirs, files);
+    scrubber->start(QThread::IdlePriority);
+}
+
+void LauncherWindow::scrubFinished(int checked, int rehashed) {
+
+    logger->append(this->objectName(), "Integrity scrubber finished: " + QString::number(checked)
+                   + " files checked, " + QString::number(rehashed) + " rehashed\n");
+
+    scrubbedKey = scrubbingKey;
+    FingerprintCache::instance()->save();
+}
+
+void LauncherWindow::storeRescanNeeded() {
+
+    // Some changes are lost, so all files should be scrubbed again
+    scrubbedKey.clear();
+    if (ui->webView->page() == page) startScrubber();
 }
 
 // Load webpage slots
@@ -252,19 +422,66 @@ void LauncherWindow::loadPageTimeout() {ui->webView->setPage(errorPage);}
 void LauncherWindow::pageLoaded(bool loaded) {
     if (loaded) {
         ui->webView->setPage(page);
+
+        // Launcher is idle on news page, good time to verify game files
+        startScrubber();
     }
 }
 
+// Waits for background task, keeping GUI alive
+template <typename T>
+static T waitFor(QFuture<T> future) {
+    QFutureWatcher<T> watcher;
+    QEventLoop loop;
+    QObject::connect(&watcher, SIGNAL(finished()), &loop, SLOT(quit()));
+    watcher.setFuture(future);
+    loop.exec();
+    return future.result();
+}
+
+static void waitFor(QFuture<void> future) {
+    QFutureWatcher<void> watcher;
+    QEventLoop loop;
+    QObject::connect(&watcher, SIGNAL(finished()), &loop, SLOT(quit()));
+    watcher.setFuture(future);
+    loop.exec();
+}
+
+// Login request, measures its own duration as it overlaps other launch phases
+static Reply makeTimedLogin(AuthSession::Session session, bool hasSession, QByteArray postData, qint64* time) {
+    QElapsedTimer timer;
+    timer.start();
+    Reply reply = AuthSession::authenticate(session, hasSession, postData);
+    *time = timer.elapsed();
+    return reply;
+}
+
 void LauncherWindow::playButtonClicked() {
 
     logger->append(this->objectName(), "Try to start game...\n");
     logger->append(this->objectName(), "Client id: "
                    + settings->getClientStrId(settings->loadActiveClientId()) + "\n");
 
+    // Game is already running or being launched (waits below run nested event loops)
+    if (session != 0 || launching) return;
+    launching = true;
+
+    launchTimer.start();
+    launchHistory.begin();
+    launchHistory.setValue("client", settings->getClientStrId(settings->loadActiveClientId()));
+
     ui->centralWidget->setEnabled(false);
     ui->menuBar->setEnabled(false);
 
-    if (!ui->playOffline->isChecked()) {
+    // Do not compete with game launch for disk
+    scrubber->pause();
+
+    bool online = !ui->playOffline->isChecked();
+    QString uuid, accessToken;
+    QFuture<Reply> loginFuture;
+    qint64 authTime = 0;
+
+    if (online) {
         logger->append(this->objectName(), "Online mode is selected\n");
 
         // Make JSON login request, see: http://wiki.vg/Authentication
@@ -286,461 +503,387 @@ void LauncherWindow::playButtonClicked() {
 
         QJsonDocument jsonRequest(payload);
 
-        logger->append(this->objectName(), "Making login request...\n");
-        Reply loginReply = Util::makePost(Settings::authUrl, jsonRequest.toJson());
-
-        if (!loginReply.isOK()) {
-
-            QMessageBox::critical(this, "У нас проблема :(", "Упс... Вот ведь незадача...\n"
-                                  + loginReply.getErrorString());
-            logger->append(this->objectName(), "Error: " + loginReply.getErrorString() + "\n");
-
-        } else { // Successful login request
-
-            QJsonParseError error;
-            QJsonDocument jsonLoginReply = QJsonDocument::fromJson(loginReply.reply(), &error);
-
-            if (!(error.error == QJsonParseError::NoError)) {
-
-                QMessageBox::critical(this, "У нас проблема :(", "При попытке логина сервер овтетил ерунду...\n\n"
-                                      + error.errorString() + " в позиции " + QString::number(error.offset));
-                logger->append(this->objectName(), "JSON parse error: " + error.errorString()
-                               + " в поз. "  + QString::number(error.offset) + "\n");
-
-            } else { // Correct login request
-
-                QJsonObject loginReplyData = jsonLoginReply.object();
-
-                if (!loginReplyData["error"].isNull()) {
-
-                    QMessageBox::critical(this, "У нас проблема :(", loginReplyData["errorMessage"].toString());
-                    logger->append(this->objectName(), "Error: " + loginReplyData["errorMessage"].toString() + "\n");
-
-                } else { // No "error" field in responce
-
-                    // Prepare to run game in online-mode
-                    logger->append(this->objectName(), "OK\n");
-
-                    QString uuid = loginReplyData["clientToken"].toString();
-                    QString accessToken = loginReplyData["accessToken"].toString();
-                    QString gameVersion = settings->loadClientVersion();
+        // Saved session makes password login unnecessary until server rejects it,
+        // it is kept only together with saved password
+        AuthSession::Session authSession;
+        bool hasSession = ui->savePassword->isChecked() && AuthSession::load(ui->nickEdit->text(), &authSession);
 
-                    // Switch from "latest" to real version
-                    bool run = true;
-                    if (gameVersion == "latest") {
+        // Login is not needed to prepare game files, so it runs in background
+        logger->append(this->objectName(), QString(hasSession ? "Checking saved session" : "Making login request")
+                       + "...\n");
+        loginFuture = QtConcurrent::run(makeTimedLogin, authSession, hasSession, jsonRequest.toJson(), &authTime);
 
-                        logger->append(this->objectName(), "Looking for 'latest' version on update server...\n");
-                        Reply versionReply = Util::makeGet(settings->getVersionsUrl());
-
-                        if (!versionReply.isOK()) {
-
-                            QMessageBox::critical(this, "У нас проблема :(", "Не удалось определить версию для запуска!\n"
-                                                  + versionReply.getErrorString());
-                            logger->append(this->objectName(), "Error: " + versionReply.getErrorString() + "\n");
-                            run = false;
-
-                        } else { // Successful version request
-
-                            QJsonParseError error;
-                            QJsonDocument jsonVersionReply = QJsonDocument::fromJson(versionReply.reply(), &error);
-
-                            if (!(error.error == QJsonParseError::NoError)) {
-
-                                QMessageBox::critical(this, "У нас проблема :(", "Не удалось понять что же нужно запустить...\n"
-                                                      + error.errorString() + " в поз. "  + QString::number(error.offset));
-                                logger->append(this->objectName(), "JSON parse error: " + error.errorString()
-                                               + " в поз. "  + QString::number(error.offset) + "\n");
-                                run = false;
+    } else {
 
-                            } else { // Correct version reply
+        logger->append(this->objectName(), "Offline mode is selected\n");
 
-                                QJsonObject latest = jsonVersionReply.object()["latest"].toObject();
-                                if (latest["release"].isNull()) {
+        uuid = QString(QUuid::createUuid().toByteArray()).remove('{').remove('}');
+        accessToken = QString(QUuid::createUuid().toByteArray()).remove('{').remove('}');
+    }
 
-                                    run = false;
-                                    QMessageBox::critical(this, "У нас проблема :(", "Не удалось определить версию для запуска!\n");
-                                    logger->append(this->objectName(), "Error: empty game version\n");
+    // Join speculative preparation, it makes the same work
+    QString prewarmKey = Prewarmer::makeKey(makePrewarmTarget());
+    prewarmPending = false;
 
-                                } else {
+    if (prewarmer->isRunning()) {
+        if (prewarmer->getKey() != prewarmKey) prewarmer->cancel();
 
-                                    gameVersion = latest["release"].toString();
-                                    logger->append(this->objectName(), "Game version is " + gameVersion + "\n");
+        QEventLoop loop;
+        connect(prewarmer, SIGNAL(finished()), &loop, SLOT(quit()));
+        if (prewarmer->isRunning()) loop.exec();
+    }
 
-                                }
-                            }
-                        }
-                    }
+    // Prepare game files while waiting for login reply
+    QString gameVersion;
+    bool prepared = false;
 
-                    // update json indexes before run (version, data, assets)
-                    logger->append(this->objectName(), "Updating game indexes..." + gameVersion + "\n");
+    if (prewarmer->isReady() && prewarmer->getKey() == prewarmKey) {
 
-                    QString currentVersionDir = settings->getVersionsDir() + "/" + gameVersion + "/" ;
+        gameVersion = prewarmer->getGameVersion();
 
-                    Util::downloadFile(settings->getVersionUrl(gameVersion) + gameVersion + ".json", currentVersionDir + gameVersion + ".json");
-                    Util::downloadFile(settings->getVersionUrl(gameVersion) + "data.json", currentVersionDir + "data.json");
+        if (prewarmer->isFresh()) {
+            prewarmHits++;
+            logger->append(this->objectName(), "Prewarm hit\n");
+            launchHistory.setValue("prewarm", "hit");
 
-                    QByteArray jsonData;
-                    jsonData.append(Util::getFileContetnts(currentVersionDir + gameVersion + ".json"));
-                    QJsonObject versionIndex = QJsonDocument::fromJson(jsonData).object();
+            gamePlan = prewarmer->getPlan();
+            gameLibpath = prewarmer->getLibpath().join((settings->getOsName() == "windows") ? ";" : ":");
+            prepared = true;
 
-                    if (!versionIndex["assets"].isNull()) {
-                        QString assets = versionIndex["assets"].toString();
-                        Util::downloadFile(settings->getAssetsUrl() + "indexes/" + assets + ".json",
-                                           settings->getAssetsDir() + "/indexes/" + assets + ".json");
-                    }
+        } else {
+            // Version and indexes are recent, but files should be checked again
+            prewarmPartialHits++;
+            logger->append(this->objectName(), "Prewarm partial hit: game store changed\n");
+            launchHistory.setValue("prewarm", "partial");
 
-                    if (run) runGame(uuid, accessToken, gameVersion);
-                }
-            }
+            prepared = prepareGame(gameVersion);
         }
 
-    } else { // Offline mode
-
-        logger->append(this->objectName(), "Offline mode is selected\n");
-
-        QString uuid = QString(QUuid::createUuid().toByteArray()).remove('{').remove('}');
-        QString accessToken = QString(QUuid::createUuid().toByteArray()).remove('{').remove('}');
-        QString gameVersion = settings->loadClientVersion();
-
-        bool run = true;
-        if (gameVersion == "latest") {
-            logger->append(this->objectName(), "Looking for 'latest' local version\n");
-
-            // Great old date for comparsion!
-            // releaseDate used for store latest founded release date and write gameVersion if this happened
-            QDateTime releaseDate = QDateTime::fromString("1991-05-18T13:15:00+07:00", Qt::ISODate);
-
-            QDir verDir = QDir(settings->getVersionsDir());
-            QStringList verList = verDir.entryList();
-
-            for (QStringList::iterator nameit = verList.begin(), end = verList.end(); nameit != end; ++nameit) {
-                QString currentVersion = (*nameit);
-                QFile* versionFile = new QFile(settings->getVersionsDir()
-                                               + "/" + currentVersion
-                                               + "/" + currentVersion + ".json");
-                if (versionFile->open(QIODevice::ReadOnly)) {
-
-                    QJsonParseError error;
-                    QJsonDocument versionJson =  QJsonDocument::fromJson(versionFile->readAll(), &error);
-                    if (error.error == QJsonParseError::NoError) {
-
-                        QString currentTimeStr = versionJson.object()["releaseTime"].toString();
-                        QDateTime curRelTime = QDateTime::fromString(currentTimeStr, Qt::ISODate);
-
-                        if (curRelTime.isValid() && (curRelTime > releaseDate)) {
-                            releaseDate = curRelTime;
-                            gameVersion = currentVersion;
-                        }
-
-                    }
-                    versionFile->close();
-                }
-                delete versionFile;
-            }
-
-            if (gameVersion == "latest") {
-                logger->append(this->objectName(), "Error: no local versions\n");
-                showUpdateDialog(QString("Похоже, что не установлено ни одной версии клиента. Выполните обновление.\n")
-                                 + "Нажмите кнопку \"Проверить\", а затем \"Обновить\"");
-                run = false;
+    } else {
+        prewarmMisses++;
+        logger->append(this->objectName(), "Prewarm miss\n");
+        launchHistory.setValue("prewarm", "miss");
+
+        QElapsedTimer phaseTimer;
+        phaseTimer.start();
+        gameVersion = resolveGameVersion(online);
+        launchHistory.addPhase("version", phaseTimer.elapsed());
+
+        if (!gameVersion.isEmpty()) {
+            if (online) {
+                phaseTimer.start();
+                refreshIndexes(gameVersion);
+                launchHistory.addPhase("indexes", phaseTimer.elapsed());
             }
+            prepared = prepareGame(gameVersion);
         }
-
-        if (run) runGame(uuid, accessToken, gameVersion);
-
     }
 
-    ui->centralWidget->setEnabled(true);
-    ui->menuBar->setEnabled(true);
-}
-
-void LauncherWindow::runGame(QString uuid, QString accessToken, QString gameVersion) {
-
-    logger->append(this->objectName(), "Preparing game to run...\n");
+    logger->append(this->objectName(), "Prewarm stats: " + QString::number(prewarmHits) + " hits, "
+                   + QString::number(prewarmPartialHits) + " partial hits, "
+                   + QString::number(prewarmMisses) + " misses\n");
+
+    bool loggedIn = true;
+    if (online) {
+        Reply loginReply = waitFor(loginFuture);
+        logger->append(this->objectName(), "Login reply at "
+                       + QString::number(launchTimer.elapsed()) + " ms\n");
+        launchHistory.addPhase("auth", authTime);
+
+        // Login errors are not important if game can't be started anyway
+        loggedIn = prepared && readLoginReply(loginReply, &uuid, &accessToken);
+
+        if (!ui->savePassword->isChecked()) {
+            // Security: no stored credentials without saved password
+            AuthSession::clear();
+        } else if (loggedIn) {
+            AuthSession::Session authSession;
+            authSession.login = ui->nickEdit->text();
+            authSession.accessToken = accessToken;
+            authSession.clientToken = uuid;
+            AuthSession::save(authSession);
+        } else if (prepared && loginReply.isOK()) {
+            // Rejected by server, not a network problem
+            AuthSession::clear();
+        }
+    }
 
-    QString java, libpath, classpath,
-            mainClass, minecraftArguments;
+    launchHistory.setValue("version", gameVersion);
 
-    // Setup java binary
-    if (settings->loadClientJavaState()) {
-        java = settings->loadClientJava();
+    if (prepared && loggedIn) {
+        runGame(uuid, accessToken, gameVersion);
     } else {
-        java = "java";
+        launchHistory.commit("aborted");
     }
 
-    // Prepare library path
-    logger->append(this->objectName(), "Prepare natives directory...\n");
-    libpath = settings->getNativesDir();
-    Util::removeAll(libpath);
+    scrubber->resume();
 
-    QDir libsDir = QDir(libpath);
-    libsDir.mkpath(libpath);
+    ui->centralWidget->setEnabled(true);
+    ui->menuBar->setEnabled(true);
 
-    if (!libsDir.exists()) {
-        QMessageBox::critical(this, "У нас проблема :(",
-                              "Не удалось подготовить LIBRARY_PATH. Извините :(");
-        logger->append(this->objectName(), "Error: can't create natives directory!\n");
+    launching = false;
+    if (closePending) {
+        close();
         return;
     }
 
-    // Open version index file
-    QFile* versionFile = new QFile(settings->getVersionsDir() + "/" + gameVersion + "/" + gameVersion + ".json");
-    logger->append(this->objectName(), "Reading version file: " + versionFile->fileName() + "\n");
+    // Launch failed, prepare the next try
+    startPrewarm();
+}
 
-    if (!versionFile->open(QIODevice::ReadOnly)) {
+bool LauncherWindow::readLoginReply(Reply loginReply, QString* uuid, QString* accessToken) {
 
-        logger->append(this->objectName(), "Error: can't open version file\n");
-        showUpdateDialog(QString("Для запуска игры необходимо выполнить обновление! ")
-                         + "Нажмите кнопку \"Проверить\", а затем \"Обновить\"");
-        delete versionFile;
-        return;
+    if (!loginReply.isOK()) {
+
+        QMessageBox::critical(this, "У нас проблема :(", "Упс... Вот ведь незадача...\n"
+                              + loginReply.getErrorString());
+        logger->append(this->objectName(), "Error: " + loginReply.getErrorString() + "\n");
+        return false;
     }
 
     QJsonParseError error;
-    QJsonObject versionIndex = QJsonDocument::fromJson(versionFile->readAll(), &error).object();
-    versionFile->close();
-    delete versionFile;
+    QJsonDocument jsonLoginReply = QJsonDocument::fromJson(loginReply.reply(), &error);
 
     if (!(error.error == QJsonParseError::NoError)) {
 
-        QMessageBox::critical(this, "У нас проблема :(", "Не удалось разобрать индекс версии...\n"
-                              + error.errorString() + "  поз. " + QString::number(error.offset));
-        logger->append(this->objectName(), "JSON parse error: " + error.errorString() + " в поз. "
-                       + QString::number(error.offset) + "\n");
-        return;
-    }
-
-    // Open data index file
-    QFile* dataIndexFile = new QFile(settings->getVersionsDir() + "/" + gameVersion + "/" + "data.json");
-    logger->append(this->objectName(), "Reading index file: " + dataIndexFile->fileName() + "\n");
-
-    if (!dataIndexFile->open(QIODevice::ReadOnly)) {
-
-        logger->append(this->objectName(), "Error: can't open data index file\n");
-        showUpdateDialog(QString("Для запуска игры необходимо выполнить обновление! ")
-                         + "Нажмите кнопку \"Проверить\", а затем \"Обновить\"");
-        delete dataIndexFile;
-        return;
+        QMessageBox::critical(this, "У нас проблема :(", "При попытке логина сервер овтетил ерунду...\n\n"
+                              + error.errorString() + " в позиции " + QString::number(error.offset));
+        logger->append(this->objectName(), "JSON parse error: " + error.errorString()
+                       + " в поз. "  + QString::number(error.offset) + "\n");
+        return false;
     }
 
-    QJsonDocument dataJson = QJsonDocument::fromJson(dataIndexFile->readAll(), &error);
-    dataIndexFile->close();
-    delete dataIndexFile;
+    QJsonObject loginReplyData = jsonLoginReply.object();
 
-    if (!(error.error == QJsonParseError::NoError)) {
+    if (!loginReplyData["error"].isNull()) {
 
-        QMessageBox::critical(this, "У нас проблема :(", "Не удалось разобрать индекс библиотек...\n"
-                              + error.errorString() + "  поз. " + QString::number(error.offset));
-        logger->append(this->objectName(), "JSON parse error: " + error.errorString() + " в поз. "
-                       + QString::number(error.offset) + "\n");
-        return;
+        QMessageBox::critical(this, "У нас проблема :(", loginReplyData["errorMessage"].toString());
+        logger->append(this->objectName(), "Error: " + loginReplyData["errorMessage"].toString() + "\n");
+        return false;
     }
 
-    // Libs size and hash index
-    QJsonObject libIndex = dataJson.object()["libs"].toObject();
-
-    QJsonArray libraries = versionIndex["libraries"].toArray();
-    foreach (QJsonValue libValue, libraries) {
+    // No "error" field in responce
+    logger->append(this->objectName(), "OK\n");
 
-        QJsonObject library = libValue.toObject();
-
-        QStringList entry = library["name"].toString().split(':');
-
-        // <package>:<name>:<version> to <package>/<name>/<version>/<name>-<version> and chahge <backage> format from a.b.c to a/b/c
-        QString libSuffix = entry.at(0);                  // package
-        libSuffix.replace('.', '/');                      // package format
-        libSuffix += "/" + entry.at(1)                    // + name
-                + "/" + entry.at(2)                       // + version
-                + "/" + entry.at(1) + "-" + entry.at(2);  // + name-version
+    *uuid = loginReplyData["clientToken"].toString();
+    *accessToken = loginReplyData["accessToken"].toString();
+    return true;
+}
 
-        // Check for allow-disallow rules
-        QJsonArray rules = library["rules"].toArray();
-        bool allowLib = true;
-        if (!rules.isEmpty()) {
+// Returns real version to run instead of 'latest', or empty string on error
+QString LauncherWindow::resolveGameVersion(bool online) {
 
-            // Disallow libray if not in allow list
-            allowLib = false;
+    QString gameVersion = settings->loadClientVersion();
+    if (gameVersion != "latest") return gameVersion;
 
-            foreach (QJsonValue ruleValue, rules) {
-                QJsonObject rule = ruleValue.toObject();
+    if (online) {
 
-                // Process allow variants (all or specified)
-                if (rule["action"].toString() == "allow") {
-                    if (rule["os"].toObject().isEmpty()) {
-                        allowLib = true;
-                    } else if (rule["os"].toObject()["name"].toString() == settings->getOsName()) {
-                        allowLib = true;
-                    }
-                }
+        logger->append(this->objectName(), "Looking for 'latest' version on update server...\n");
+        Reply versionReply = waitFor(QtConcurrent::run(Util::makeGet, settings->getVersionsUrl()));
 
-                // Make exclusions from allow-list
-                if (rule["action"].toString() == "disallow") {
-                    if (rule["os"].toObject()["name"].toString() == settings->getOsName()) {
-                        allowLib = false;
-                    }
-                }
-            }
-        }
+        if (!versionReply.isOK()) {
 
-        if (!allowLib) {
-            logger->append(this->objectName(), "Skipping lib: " + libSuffix + ".jar\n");
-            continue;
+            QMessageBox::critical(this, "У нас проблема :(", "Не удалось определить версию для запуска!\n"
+                                  + versionReply.getErrorString());
+            logger->append(this->objectName(), "Error: " + versionReply.getErrorString() + "\n");
+            return "";
         }
 
-        if (library["natives"].isNull()) {
+        QJsonParseError error;
+        QJsonDocument jsonVersionReply = QJsonDocument::fromJson(versionReply.reply(), &error);
 
-            if (!isValidGameFile(settings->getLibsDir() + "/" + libSuffix + ".jar", libIndex[libSuffix + ".jar"].toObject()["hash"].toString())) {
-
-                showUpdateDialog(QString("Для запуска игры необходимо выполнить обновление! ")
-                                 + "Нажмите кнопку \"Проверить\", а затем \"Обновить\"");
-                return;
-            }
-
-            if (settings->getOsName() == "windows") libSuffix += ".jar;";
-            else libSuffix += ".jar:";
-
-            classpath += settings->getLibsDir() + "/" + libSuffix;
-
-        } else {
-
-            QString nativesSuffix = library["natives"].toObject()[settings->getOsName()].toString();
-            nativesSuffix.replace("${arch}", settings->getWordSize());
+        if (!(error.error == QJsonParseError::NoError)) {
 
-            if (!nativesSuffix.isEmpty()) {
-                libSuffix += "-" + nativesSuffix + ".jar";
-            } else {
-                libSuffix += ".jar";
-            }
+            QMessageBox::critical(this, "У нас проблема :(", "Не удалось понять что же нужно запустить...\n"
+                                  + error.errorString() + " в поз. "  + QString::number(error.offset));
+            logger->append(this->objectName(), "JSON parse error: " + error.errorString()
+                           + " в поз. "  + QString::number(error.offset) + "\n");
+            return "";
+        }
 
-            if (!isValidGameFile(settings->getLibsDir() + "/" + libSuffix, libIndex[libSuffix].toObject()["hash"].toString())) {
+        QJsonObject latest = jsonVersionReply.object()["latest"].toObject();
+        if (latest["release"].isNull()) {
 
-                showUpdateDialog(QString("Для запуска игры необходимо выполнить обновление! ")
-                                 + "Нажмите кнопку \"Проверить\", а затем \"Обновить\"");
-                return;
-            }
-            Util::unzipArchive(settings->getLibsDir() + "/" + libSuffix, settings->getNativesDir());
+            QMessageBox::critical(this, "У нас проблема :(", "Не удалось определить версию для запуска!\n");
+            logger->append(this->objectName(), "Error: empty game version\n");
+            return "";
         }
 
-
+        gameVersion = latest["release"].toString();
+        logger->append(this->objectName(), "Game version is " + gameVersion + "\n");
+        return gameVersion;
     }
 
-    // Add game jar to classpath
-    classpath += settings->getVersionsDir() + "/" + gameVersion + "/" + gameVersion + ".jar";
+    logger->append(this->objectName(), "Looking for 'latest' local version\n");
 
-    QString jarHash = dataJson.object()["main"].toObject()["hash"].toString();
-    if (!isValidGameFile(settings->getVersionsDir() + "/" + gameVersion + "/" + gameVersion + ".jar", jarHash)) {
-        showUpdateDialog(QString("Для запуска игры необходимо выполнить обновление! ")
+    QString latest = VersionsCatalog::findLatest(settings->getClientStrId(settings->loadActiveClientId()));
+    if (!latest.isEmpty()) gameVersion = latest;
+
+    if (gameVersion == "latest") {
+        logger->append(this->objectName(), "Error: no local versions\n");
+        showUpdateDialog(QString("Похоже, что не установлено ни одной версии клиента. Выполните обновление.\n")
                          + "Нажмите кнопку \"Проверить\", а затем \"Обновить\"");
-        return;
+        return "";
     }
 
-    // Open custom files index
-    if (!dataJson.object()["files"].toObject()["index"].isNull()) {
+    return gameVersion;
+}
 
-        QJsonObject customFilesObject = dataJson.object()["files"].toObject();
+// Update json indexes before run (version, data, assets)
+void LauncherWindow::refreshIndexes(QString gameVersion) {
 
-        QStringList mutableFileList;
-        QJsonArray mutableFileIndex = customFilesObject["mutables"].toArray();
-        foreach (QJsonValue entry, mutableFileIndex) {
-            mutableFileList.append(entry.toString());
-        }
+    logger->append(this->objectName(), "Updating game indexes..." + gameVersion + "\n");
 
-        QJsonObject regularFileIndex = customFilesObject["index"].toObject();
-        QString filesPrefix = settings->getClientPrefix(gameVersion);
+    QString currentVersionDir = settings->getVersionsDir() + "/" + gameVersion + "/" ;
+    QString versionUrl = settings->getVersionUrl(gameVersion);
 
-        foreach (QString file, regularFileIndex.keys()) {
+    // Data index is independent, assets index name is known from version index only
+    QFuture<bool> versionIndex = QtConcurrent::run(Util::downloadFile, versionUrl + gameVersion + ".json",
+                                                   currentVersionDir + gameVersion + ".json");
+    QFuture<bool> dataIndex = QtConcurrent::run(Util::downloadFile, versionUrl + "data.json",
+                                                currentVersionDir + "data.json");
+    waitFor(versionIndex);
+    VersionsCatalog::update(settings->getClientStrId(settings->loadActiveClientId()), gameVersion);
 
-            QString hash;
-            if (mutableFileList.indexOf(file) == -1) {
-                hash = regularFileIndex[file].toObject()["hash"].toString();
-            } else {
-                hash = "mutable";
-            }
+    GameIndex::VersionIndex versionIndexData = IndexCache::readVersion(currentVersionDir + gameVersion + ".json");
 
-            if (!isValidGameFile(filesPrefix + "/" + file, hash)) {
-                showUpdateDialog(QString("Для запуска игры необходимо выполнить обновление! ")
-                                 + "Нажмите кнопку \"Проверить\", а затем \"Обновить\"");
-                return;
-            }
-        }
+    if (!versionIndexData.assets.isEmpty()) {
+        QString assets = versionIndexData.assets;
+        waitFor(QtConcurrent::run(Util::downloadFile, settings->getAssetsUrl() + "indexes/" + assets + ".json",
+                                  settings->getAssetsDir() + "/indexes/" + assets + ".json"));
     }
 
-    // Setup mainClass
-    if (versionIndex["mainClass"].isNull()) {
-
-        QMessageBox::critical(this, "У нас проблема :(", "Вот беда. В конфигурационном файле не указан mainClass.");
-        logger->append(this->objectName(), "Error: can't read mainClass\n");
-        return;
-
-    } else {
+    waitFor(dataIndex);
 
-        mainClass = versionIndex["mainClass"].toString();
+    logger->append(this->objectName(), "Updated game indexes at "
+                   + QString::number(launchTimer.elapsed()) + " ms\n");
+}
 
-    }
+// Resolves launch plan, checks game files and prepares natives (concurrently)
+bool LauncherWindow::prepareGame(QString gameVersion) {
 
-    // Read assets index
-    QString assetsVersion;
-    if (versionIndex["assets"].isNull()) {
+    logger->append(this->objectName(), "Preparing game to run...\n");
 
-        QMessageBox::critical(this, "У нас проблема !!!",  "Аааа! В конфигурационном файле не указаны ресурсы игры!");
-        logger->append(this->objectName(), "Error: can't read assets index name\n");
-        return;
+    QString java;
 
+    // Setup java binary, best installed runtime for the version by default
+    // (runtimes are probed in background, not on GUI thread)
+    if (settings->loadClientJavaState()) {
+        java = settings->loadClientJava();
     } else {
+        int javaMajor = VersionsCatalog::getJavaMajor(settings->getClientStrId(settings->loadActiveClientId()),
+                                                      gameVersion);
 
-        assetsVersion = versionIndex["assets"].toString();
+        // New or updated runtimes are not known until the probe finishes
+        if (!javaRefresh.isFinished()) {
+            logger->append(this->objectName(), "Waiting for Java runtimes probe...\n");
+            waitFor(javaRefresh);
+        }
+        java = JavaRegistry::instance()->selectCachedJava(javaMajor);
+    }
 
-        // Open assets index file
-        QFile* assetIndexFile = new QFile(settings->getAssetsDir() + "/indexes/" + assetsVersion + ".json");
-        logger->append(this->objectName(), "Reading index file: " + assetIndexFile->fileName() + "\n");
+    // Resolve launch plan, cached one is used while indexes are unchanged
+    QElapsedTimer phaseTimer;
+    phaseTimer.start();
 
-        if (!assetIndexFile->open(QIODevice::ReadOnly)) {
+    LaunchPlan plan;
+    if (!plan.resolve(settings->getClientStrId(settings->loadActiveClientId()), gameVersion, java)) {
 
-            logger->append(this->objectName(), "Error: can't open index file\n");
+        switch (plan.getError()) {
+        case LaunchPlan::IndexNotFound:
+        case LaunchPlan::DataIndexNotFound:
+        case LaunchPlan::AssetsIndexNotFound:
+            logger->append(this->objectName(), "Error: " + plan.getErrorString() + "\n");
             showUpdateDialog(QString("Для запуска игры необходимо выполнить обновление! ")
                              + "Нажмите кнопку \"Проверить\", а затем \"Обновить\"");
-            delete assetIndexFile;
-            return;
-        }
-
-        QJsonObject assetIndex = QJsonDocument::fromJson(assetIndexFile->readAll(), &error).object()["objects"].toObject();
-        assetIndexFile->close();
-        delete assetIndexFile;
+            break;
 
-        if (!(error.error == QJsonParseError::NoError)) {
+        case LaunchPlan::NoMainClass:
+            QMessageBox::critical(this, "У нас проблема :(", "Вот беда. В конфигурационном файле не указан mainClass.");
+            logger->append(this->objectName(), "Error: can't read mainClass\n");
+            break;
 
-            QMessageBox::critical(this, "У нас проблема :(", "Не удалось разобрать индекс ресурсов...\n"
-                                  + error.errorString() + "  поз. " + QString::number(error.offset));
-            logger->append(this->objectName(), "JSON parse error: " + error.errorString() + " в поз. "
-                           + QString::number(error.offset) + "\n");
-            return;
-        }
+        case LaunchPlan::NoAssets:
+            QMessageBox::critical(this, "У нас проблема !!!",  "Аааа! В конфигурационном файле не указаны ресурсы игры!");
+            logger->append(this->objectName(), "Error: can't read assets index name\n");
+            break;
 
-        QString assetsPrefix = settings->getAssetsDir() + "/objects/";
-        foreach (QString key, assetIndex.keys()) {
+        case LaunchPlan::NoArguments:
+            QMessageBox::critical(this, "У нас проблема :(", "В конфигурационном файле не указаны аргументы запуска.");
+            logger->append(this->objectName(), "Error: can't read minecraft arguments\n");
+            break;
 
-            QString hash = assetIndex[key].toObject()["hash"].toString();;
-            QString assetSuffix = hash.mid(0, 2);
+        case LaunchPlan::IndexParseError:
+        default:
+            QMessageBox::critical(this, "У нас проблема :(", "Не удалось разобрать индексы игры...\n"
+                                  + plan.getErrorString());
+            logger->append(this->objectName(), "Error: " + plan.getErrorString() + "\n");
+            break;
+        }
+        return false;
+    }
 
-            if (!isValidGameFile(assetsPrefix + assetSuffix + "/" + hash, hash)) {
-                showUpdateDialog(QString("Для запуска игры необходимо выполнить обновление! ")
-                                 + "Нажмите кнопку \"Проверить\", а затем \"Обновить\"");
-                return;
-            }
+    logger->append(this->objectName(), QString(plan.isCached() ? "Cached" : "Resolved") + " launch plan in "
+                   + QString::number(launchTimer.elapsed()) + " ms\n");
+    launchHistory.addPhase("classpath", phaseTimer.elapsed());
+
+    // Check game files (libraries, game jar, custom files and assets) while natives are prepared
+    qint64 checkTimes[LaunchPlan::CheckGroupCount];
+    QFuture<QString> checkFuture = QtConcurrent::run(plan, &LaunchPlan::findInvalidFile, checkTimes);
+
+    // Prepare library path, natives are extracted once per native jar
+    logger->append(this->objectName(), "Prepare natives directories...\n");
+    QString librarySeparator = (settings->getOsName() == "windows") ? ";" : ":";
+    QStringList libpathList;
+
+    QString nativesError;
+    phaseTimer.start();
+    bool nativesReady = waitFor(QtConcurrent::run(NativesCache::prepare, plan.getNatives(),
+                                                  &libpathList, &nativesError));
+    launchHistory.addPhase("natives", phaseTimer.elapsed());
+
+    QString invalidFile = waitFor(checkFuture);
+    logger->append(this->objectName(), "Checked " + QString::number(plan.getChecks().size()) + " files at "
+                   + QString::number(launchTimer.elapsed()) + " ms\n");
+
+    if (invalidFile.isEmpty()) {
+        for (int group = 0; group < LaunchPlan::CheckGroupCount; group++) {
+            launchHistory.addPhase("check_" + LaunchPlan::getCheckGroupName(LaunchPlan::CheckGroup(group)),
+                                   checkTimes[group]);
         }
+    } else {
+        logger->append(this->objectName(), "Precheck: missing or bad file: " + invalidFile + "\n");
+        showUpdateDialog(QString("Для запуска игры необходимо выполнить обновление! ")
+                         + "Нажмите кнопку \"Проверить\", а затем \"Обновить\"");
+        return false;
+    }
+
+    if (!nativesReady) {
+        QMessageBox::critical(this, "У нас проблема :(",
+                              "Не удалось подготовить LIBRARY_PATH. Извините :(\n" + nativesError);
+        logger->append(this->objectName(), "Error: can't prepare natives: " + nativesError + "\n");
+        return false;
     }
 
-    // Setup aruments
-    if (versionIndex["minecraftArguments"].isNull()) {
+    logger->append(this->objectName(), "Prepared natives at "
+                   + QString::number(launchTimer.elapsed()) + " ms\n");
 
-        QMessageBox::critical(this, "У нас проблема :(", "В конфигурационном файле не указаны аргументы запуска.");
-        logger->append(this->objectName(), "Error: can't read minecraft arguments\n");
-        return;
+    gamePlan = plan;
+    gameLibpath = libpathList.join(librarySeparator);
+    return true;
+}
 
-    } else {
+void LauncherWindow::runGame(QString uuid, QString accessToken, QString gameVersion) {
 
-        minecraftArguments = versionIndex["minecraftArguments"].toString();
-    }
+    QElapsedTimer phaseTimer;
+    phaseTimer.start();
+
+    QString java = gamePlan.getJava();
+    QString libpath = gameLibpath;
+    QString classpath = gamePlan.getClasspath();
+    QString mainClass = gamePlan.getMainClass();
+    QString minecraftArguments = gamePlan.getArguments();
+    QString assetsVersion = gamePlan.getAssetsId();
 
     // Crazy way, but this must work
     QStringList mcArgList;
@@ -788,145 +931,183 @@ void LauncherWindow::runGame(QString uuid, QString accessToken, QString gameVers
     if (settings->loadClientJavaArgsState()) {
         userArgList = settings->loadClientJavaArgs().split(" ");
     }
+
+    // Heap and collector for this system, user args take precedence
+    if (settings->loadClientPerfProfileState()) {
+        QStringList profileArgList = JvmProfile::makeArguments(JavaRegistry::instance()->getCachedRuntime(java),
+                                                               gamePlan.getMemoryHint(), userArgList);
+        argList << profileArgList;
+        launchHistory.setValue("jvm_profile", profileArgList.join(' '));
+    }
+
     if (!userArgList.isEmpty()) argList << userArgList;
 
-    argList << "-Djava.library.path=" + libpath
-            << "-cp" << classpath
-            << mainClass
+    // Class data sharing archive, made by the first run of the version
+    if (settings->loadClientCdsState()) {
+        gameCds.prepare(java, settings->getClientStrId(settings->loadActiveClientId()), gameVersion, classpath);
+        argList << gameCds.getArguments();
+    }
+
+    // Classpath is passed by argument file, if java supports it
+    QString argFile = gamePlan.getArgFile();
+    argList << "-Djava.library.path=" + libpath;
+    if (argFile.isEmpty()) {
+        argList << "-cp" << classpath;
+    } else {
+        argList << "@" + argFile;
+    }
+    argList << mainClass
             << mcArgList;
 
     QString stringargs = argList.join(' ');
     logger->append(this->objectName(), "Run string: " + java + " " + stringargs + "\n");
 
     logger->append(this->objectName(), "Try to launch game...\n");
-    QProcess* minecraft = new QProcess(this);
-    minecraft->setProcessChannelMode(QProcess::MergedChannels);
 
     // Set working directory
     QDir(settings->getClientPrefix(gameVersion)).mkpath(settings->getClientPrefix(gameVersion));
-    minecraft->setWorkingDirectory(settings->getClientPrefix(gameVersion));
-
-    minecraft->start(java, argList);
-
-    if (!minecraft->waitForStarted()) {
-
-        switch(minecraft->error()) {
-        case QProcess::FailedToStart:
-            QMessageBox::critical(this, "Проблема!",
-                                  "Смерть на взлёте! Игра не запускается!\n"
-                                  + minecraft->errorString());
-            logger->append(this->objectName(), "Error: failed to start: "
-                           + minecraft->errorString() + "\n");
-            break;
 
-        case QProcess::Crashed:
-            QMessageBox::critical(this, "Проблема!",
-                                  "Игра упала и не подымается :(\n"
-                                  + minecraft->errorString());
-            logger->append(this->objectName(), "Error: crashed: "
-                           + minecraft->errorString() + "\n");
-            break;
+    launchHistory.addPhase("args", phaseTimer.elapsed());
+    launchHistory.setValue("cds", gameCds.getModeString());
 
-        case QProcess::Timedout:
-            QMessageBox::critical(this, "Проблема!",
-                                  "Что-то долго игра не может запуститься...\n"
-                                  + minecraft->errorString());
-            logger->append(this->objectName(), "Error: timeout: "
-                           + minecraft->errorString() + "\n");
-            break;
+    session = new GameSession(this);
+    connect(session, SIGNAL(started()), this, SLOT(gameStarted()));
+    connect(session, SIGNAL(firstOutput(qint64)), this, SLOT(gameOutputStarted(qint64)));
+    connect(session, SIGNAL(failed()), this, SLOT(gameFailed()));
+    connect(session, SIGNAL(finished(int,bool)), this, SLOT(gameFinished(int,bool)));
 
-        case QProcess::WriteError:
-            QMessageBox::critical(this, "Проблема!",
-                                  "Игра не может писать :(\n"
-                                  + minecraft->errorString());
-            logger->append(this->objectName(), "Error: write error: "
-                           + minecraft->errorString() + "\n");
-            break;
+    if (settings->loadClientResourcesState()) {
+        ResourceControls::Limits limits;
+        ResourceControls::parseCpuList(settings->loadClientCpus(), &limits.cpus);
+        limits.nice = settings->loadClientNice();
+        limits.memoryLimit = settings->loadClientMemoryLimit();
 
-        case QProcess::ReadError:
-            QMessageBox::critical(this, "Проблема!",
-                                  "Игра не может читать :(!\n"
-                                  + minecraft->errorString());
-            logger->append(this->objectName(), "Error: read error: "
-                           + minecraft->errorString() + "\n");
-            break;
+        logger->append(this->objectName(), "Game resources: cores '" + settings->loadClientCpus() + "', nice "
+                       + QString::number(limits.nice) + ", memory " + QString::number(limits.memoryLimit) + " MiB\n");
+        session->setLimits(limits);
+    }
 
-        case QProcess::UnknownError:
-        default:
-            QMessageBox::critical(this, "Проблема!",
-                                  "Произошло что-то странное и игра не запустилась!\n"
-                                  + minecraft->errorString());
-            logger->append(this->objectName(), "Error: "
-                           + minecraft->errorString() + "\n");
-            break;
-        }
+    session->start(java, argList, settings->getClientPrefix(gameVersion));
+}
 
-    } else { // Game successful started
+void LauncherWindow::gameStarted() {
 
-        logger->append(this->objectName(), "Main window hidden\n");
-        this->hide();
+    logger->append(this->objectName(), "Game started in "
+                   + QString::number(launchTimer.elapsed()) + " ms\n");
+    launchHistory.addPhase("spawn", session->getElapsed());
 
-        while (minecraft->state() == QProcess::Running) {
-            if (minecraft->waitForReadyRead()) {
-                logger->append("Client", minecraft->readAll());
-            }
-        }
+    // Natives of other library sets are not needed anymore
+    QString librarySeparator = (settings->getOsName() == "windows") ? ";" : ":";
+    NativesCache::cleanup(settings->getClientStrId(settings->loadActiveClientId()),
+                          gameLibpath.split(librarySeparator, QString::SkipEmptyParts));
 
-        logger->append(this->objectName(), "Game process finished!\n");
-        if (minecraft->exitCode() != 0) {
+    logger->append(this->objectName(), "Main window hidden\n");
+    this->hide();
+}
 
-            this->show();
-            QMessageBox::critical(this, "Ну вот!",  "Кажется игра некорректно завершилась, посмотрите лог-файл.\n");
-            logger->append(this->objectName(), "Error: not null game exit code: " + QString::number(minecraft->exitCode()) + "\n");
-            logger->append(this->objectName(), "Main window showed\n");
+void LauncherWindow::gameOutputStarted(qint64 startupTime) {
 
-        } else {
+    // Compare with and without archive to see if CDS helps
+    logger->append(this->objectName(), "JVM startup time: " + QString::number(startupTime)
+                   + " ms, CDS archive: " + gameCds.getModeString() + "\n");
 
-            this->close();
+    launchHistory.addPhase("first_output", startupTime);
+    launchHistory.addPhase("total", launchTimer.elapsed());
+    launchHistory.commit("started");
+}
 
-        }
+void LauncherWindow::gameFailed() {
+
+    switch(session->getError()) {
+    case QProcess::FailedToStart:
+        QMessageBox::critical(this, "Проблема!",
+                              "Смерть на взлёте! Игра не запускается!\n"
+                              + session->getErrorString());
+        logger->append(this->objectName(), "Error: failed to start: "
+                       + session->getErrorString() + "\n");
+        break;
+
+    case QProcess::Crashed:
+        QMessageBox::critical(this, "Проблема!",
+                              "Игра упала и не подымается :(\n"
+                              + session->getErrorString());
+        logger->append(this->objectName(), "Error: crashed: "
+                       + session->getErrorString() + "\n");
+        break;
+
+    case QProcess::Timedout:
+        QMessageBox::critical(this, "Проблема!",
+                              "Что-то долго игра не может запуститься...\n"
+                              + session->getErrorString());
+        logger->append(this->objectName(), "Error: timeout: "
+                       + session->getErrorString() + "\n");
+        break;
+
+    case QProcess::WriteError:
+        QMessageBox::critical(this, "Проблема!",
+                              "Игра не может писать :(\n"
+                              + session->getErrorString());
+        logger->append(this->objectName(), "Error: write error: "
+                       + session->getErrorString() + "\n");
+        break;
+
+    case QProcess::ReadError:
+        QMessageBox::critical(this, "Проблема!",
+                              "Игра не может читать :(!\n"
+                              + session->getErrorString());
+        logger->append(this->objectName(), "Error: read error: "
+                       + session->getErrorString() + "\n");
+        break;
+
+    case QProcess::UnknownError:
+    default:
+        QMessageBox::critical(this, "Проблема!",
+                              "Произошло что-то странное и игра не запустилась!\n"
+                              + session->getErrorString());
+        logger->append(this->objectName(), "Error: "
+                       + session->getErrorString() + "\n");
+        break;
     }
 
-    delete minecraft;
+    gameCds.finish(false);
+    launchHistory.commit("failed");
+
+    session->deleteLater();
+    session = 0;
 
+    startPrewarm();
 }
 
-bool LauncherWindow::isValidGameFile(QString fileName, QString hash) {
+void LauncherWindow::gameFinished(int exitCode, bool crashed) {
 
-    logger->append(this->objectName(), "Precheck: " + fileName + "\n");
+    logger->append(this->objectName(), "Game process finished!\n");
 
-    if (!QFile::exists(fileName)) {
+    gameCds.finish(exitCode == 0 && !crashed);
 
-        logger->append(this->objectName(), "Precheck: file not exists!\n");
-        return false;
-    }
+    // Game finished without any output
+    launchHistory.addPhase("total", launchTimer.elapsed());
+    launchHistory.commit("started");
 
-    if (hash == "mutable") return true;
+    session->deleteLater();
+    session = 0;
 
-    QFile* file = new QFile(fileName);
-    if (!file->open(QIODevice::ReadOnly)) {
+    if (exitCode != 0 || crashed) {
 
-        logger->append(this->objectName(), "Precheck: can't read file!\n");
-        delete file;
-        return false;
+        this->show();
+        QMessageBox::critical(this, "Ну вот!",  "Кажется игра некорректно завершилась, посмотрите лог-файл.\n");
+        logger->append(this->objectName(), "Error: not null game exit code: " + QString::number(exitCode) + "\n");
+        logger->append(this->objectName(), "Main window showed\n");
 
-    } else {
+        startPrewarm();
 
-        QByteArray data = file->readAll();
-        QString fileHash = QString(QCryptographicHash::hash(data, QCryptographicHash::Sha1).toHex());
-        file->close();
-        delete file;
+    } else {
 
-        if (fileHash != hash) {
+        this->close();
 
-            logger->append(this->objectName(), "Precheck: bad checksumm!\n");
-            return false;
-        }
     }
-
-    return true;
 }
 
+
 LauncherWindow::~LauncherWindow() {
 
     delete ui;
@@ -4,9 +4,17 @@
 #include <QMainWindow>
 #include <QActionGroup>
 #include <QWebPage>
+#include <QFuture>
 
 #include "settings.h"
 #include "logger.h"
+#include "integrityscrubber.h"
+#include "launchplan.h"
+#include "gamesession.h"
+#include "reply.h"
+#include "prewarmer.h"
+#include "cdsarchive.h"
+#include "launchhistory.h"
 
 namespace Ui {
 class LauncherWindow;
@@ -43,6 +51,17 @@ private slots:
 
     void switchBuilderMenuVisibility();
 
+    void gameStarted();
+    void gameOutputStarted(qint64 startupTime);
+    void gameFailed();
+    void gameFinished(int exitCode, bool crashed);
+
+    void startPrewarm();
+    void prewarmFinished();
+
+    void scrubFinished(int checked, int rehashed);
+    void storeRescanNeeded();
+
     void showCloneDialog();
     void showFetchDialog();
     void showCheckoutDialog();
@@ -60,10 +79,39 @@ private:
     QWebPage* loadingPage;
     QWebPage* errorPage;
 
+    GameSession* session;
+    bool launching;    // playButtonClicked() is running its nested event loops
+    bool closePending; // Window close is deferred until launch is done
+    QElapsedTimer launchTimer;
+    LaunchHistory launchHistory;
+
+    // Prepared by prepareGame() for runGame()
+    LaunchPlan gamePlan;
+    QString gameLibpath;
+
+    CdsArchive gameCds;
+
+    QFuture<void> javaRefresh; // Background probe of Java runtimes
+
+    Prewarmer* prewarmer;
+    bool prewarmPending;
+    int prewarmHits;
+    int prewarmPartialHits;
+    int prewarmMisses;
+    Prewarmer::Target makePrewarmTarget();
+
+    IntegrityScrubber* scrubber;
+    QString scrubbingKey;
+    QString scrubbedKey;
+    void startScrubber();
+
     void loadPage(const QUrl& url);
     void storeParameters();
 
-    bool isValidGameFile(QString fileName, QString hash);
+    QString resolveGameVersion(bool online);
+    void refreshIndexes(QString gameVersion);
+    bool prepareGame(QString gameVersion);
+    bool readLoginReply(Reply loginReply, QString* uuid, QString* accessToken);
     void runGame(QString uuid, QString accessToken, QString gameVersion);
 
     void unzipAllFiles(QString zipFilePath, QString extractionPath);
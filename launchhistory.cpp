@@ -0,0 +1,139 @@
+#include "launchhistory.h"
+#include "settings.h"
+#include "logger.h"
+
+#include <algorithm>
+
+// History is trimmed to last records when it grows over the limit
+static const int historyRecords = 200;
+static const qint64 historySizeLimit = 256 * 1024;
+
+static const char* phaseOrder[] = {
+    "auth", "version", "indexes", "classpath",
+    "check_libraries", "check_jar", "check_custom", "check_assets",
+    "natives", "args", "spawn", "first_output", "total", 0
+};
+
+LaunchHistory::LaunchHistory() {
+    active = false;
+}
+
+QString LaunchHistory::getHistoryFileName() {
+    return Settings::instance()->getBaseDir() + "/launch_history.json";
+}
+
+void LaunchHistory::begin() {
+    record = QJsonObject();
+    phases = QJsonObject();
+    record["time"] = QDateTime::currentDateTime().toString(Qt::ISODate);
+    active = true;
+}
+
+bool LaunchHistory::isActive() { return active; }
+
+void LaunchHistory::addPhase(QString phase, qint64 time) {
+    if (!active) return;
+    phases[phase] = double(time);
+}
+
+void LaunchHistory::setValue(QString key, QString value) {
+    if (!active) return;
+    record[key] = value;
+}
+
+void LaunchHistory::commit(QString result) {
+
+    if (!active) return;
+    active = false;
+
+    record["result"] = result;
+    record["phases"] = phases;
+
+    QString fileName = getHistoryFileName();
+    QByteArray line = QJsonDocument(record).toJson(QJsonDocument::Compact) + "\n";
+
+    // Keep only recent records
+    QFile historyFile(fileName);
+    if (historyFile.size() > historySizeLimit && historyFile.open(QIODevice::ReadOnly)) {
+        QList<QByteArray> lines = historyFile.readAll().split('\n');
+        historyFile.close();
+
+        QByteArray trimmed;
+        for (int i = qMax(0, lines.size() - historyRecords); i < lines.size(); i++) {
+            if (!lines[i].isEmpty()) trimmed += lines[i] + "\n";
+        }
+        line = trimmed + line;
+
+        historyFile.remove();
+    }
+
+    if (!historyFile.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        Logger::logger()->append("LaunchHistory", "Error: can't write history: " + historyFile.errorString() + "\n");
+        return;
+    }
+    historyFile.write(line);
+    historyFile.close();
+
+    QStringList timings;
+    for (QJsonObject::const_iterator it = phases.constBegin(); it != phases.constEnd(); ++it) {
+        timings << it.key() + "=" + QString::number(qint64(it.value().toDouble()));
+    }
+    Logger::logger()->append("LaunchHistory", "Launch " + result + ": " + timings.join(", ") + " ms\n");
+}
+
+QList<LaunchHistory::PhaseStats> LaunchHistory::loadStats() {
+
+    QHash<QString, QList<qint64> > times;
+
+    QFile historyFile(getHistoryFileName());
+    if (historyFile.open(QIODevice::ReadOnly)) {
+        while (!historyFile.atEnd()) {
+            QJsonObject entry = QJsonDocument::fromJson(historyFile.readLine()).object();
+
+            // Aborted launches would hide the real launch time
+            if (entry.value("result").toString() != "started") continue;
+
+            QJsonObject entryPhases = entry.value("phases").toObject();
+            for (QJsonObject::const_iterator it = entryPhases.constBegin(); it != entryPhases.constEnd(); ++it) {
+                times[it.key()].append(qint64(it.value().toDouble()));
+            }
+        }
+        historyFile.close();
+    }
+
+    QList<PhaseStats> stats;
+    for (int i = 0; phaseOrder[i] != 0; i++) {
+        QList<qint64> values = times.value(phaseOrder[i]);
+        if (values.isEmpty()) continue;
+
+        std::sort(values.begin(), values.end());
+
+        // Nearest-rank percentiles
+        PhaseStats phaseStats;
+        phaseStats.phase = phaseOrder[i];
+        phaseStats.count = values.size();
+        phaseStats.p50 = values[qMax(0, (values.size() * 50 + 99) / 100 - 1)];
+        phaseStats.p95 = values[qMax(0, (values.size() * 95 + 99) / 100 - 1)];
+        stats.append(phaseStats);
+    }
+
+    return stats;
+}
+
+QString LaunchHistory::getPhaseTitle(QString phase) {
+
+    if (phase == "auth") return "Авторизация";
+    if (phase == "version") return "Выбор версии";
+    if (phase == "indexes") return "Обновление индексов";
+    if (phase == "classpath") return "Сборка classpath";
+    if (phase == "check_libraries") return "Проверка библиотек";
+    if (phase == "check_jar") return "Проверка клиента";
+    if (phase == "check_custom") return "Проверка доп. файлов";
+    if (phase == "check_assets") return "Проверка ресурсов";
+    if (phase == "natives") return "Распаковка natives";
+    if (phase == "args") return "Параметры запуска";
+    if (phase == "spawn") return "Создание процесса";
+    if (phase == "first_output") return "Старт JVM";
+    if (phase == "total") return "Всего";
+    return phase;
+}
@@ -0,0 +1,43 @@
+#ifndef LAUNCHHISTORY_H
+#define LAUNCHHISTORY_H
+
+#include <QtCore>
+
+// Durations of launch phases. Each launch is appended as one JSON line
+// to <base>/launch_history.json, percentiles are calculated from it.
+class LaunchHistory
+{
+public:
+    struct PhaseStats {
+        QString phase;
+        int count;
+        qint64 p50;
+        qint64 p95;
+    };
+
+    LaunchHistory();
+
+    // Starts a new record, unfinished one is dropped
+    void begin();
+    bool isActive();
+
+    void addPhase(QString phase, qint64 time);
+    void setValue(QString key, QString value);
+
+    // Appends record with result ("started", "aborted", "failed") to history
+    void commit(QString result);
+
+    // Statistics of started launches, phases in launch order
+    static QList<PhaseStats> loadStats();
+    static QString getPhaseTitle(QString phase);
+
+private:
+    bool active;
+    QJsonObject record;
+    QJsonObject phases;
+
+    static QString getHistoryFileName();
+
+};
+
+#endif // LAUNCHHISTORY_H
@@ -0,0 +1,350 @@
+#include "launchplan.h"
+
+#include "installplan.h"
+#include "settings.h"
+#include "logger.h"
+#include "fingerprintcache.h"
+#include "util.h"
+#include "javaregistry.h"
+
+#include <QCryptographicHash>
+#include <QSaveFile>
+
+static const quint32 launchCacheMagic = 0x7474796C; // "ttyl"
+static const quint32 launchCacheFormat = 4;
+
+static QByteArray readIndex(QString fileName, bool* found) {
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        *found = false;
+        return QByteArray();
+    }
+
+    *found = true;
+    QByteArray data = file.readAll();
+    file.close();
+    return data;
+}
+
+static QDataStream& operator<<(QDataStream& out, const LaunchPlan::Native& n) {
+    out << n.path << n.hash << n.excludes;
+    return out;
+}
+
+static QDataStream& operator>>(QDataStream& in, LaunchPlan::Native& n) {
+    in >> n.path >> n.hash >> n.excludes;
+    return in;
+}
+
+LaunchPlan::LaunchPlan() {
+    error = NoError;
+    cached = false;
+    memoryHint = 0;
+}
+
+LaunchPlan::Error LaunchPlan::getError() { return error; }
+QString LaunchPlan::getErrorString() { return errorString; }
+bool LaunchPlan::isCached() { return cached; }
+
+QString LaunchPlan::getJava() { return java; }
+QString LaunchPlan::getClasspath() { return classpath; }
+QString LaunchPlan::getArgFile() { return argFile; }
+QList<LaunchPlan::Native> LaunchPlan::getNatives() { return natives; }
+QString LaunchPlan::getMainClass() { return mainClass; }
+QString LaunchPlan::getAssetsId() { return assetsId; }
+QString LaunchPlan::getArguments() { return arguments; }
+int LaunchPlan::getMemoryHint() { return memoryHint; }
+QList<LaunchPlan::Check> LaunchPlan::getChecks(CheckGroup group) { return checks[group]; }
+
+QList<LaunchPlan::Check> LaunchPlan::getChecks() {
+    QList<Check> all;
+    for (int group = 0; group < CheckGroupCount; group++) all << checks[group];
+    return all;
+}
+
+QString LaunchPlan::getCheckGroupName(CheckGroup group) {
+    switch (group) {
+    case LibraryChecks: return "libraries";
+    case GameJarChecks: return "jar";
+    case CustomFileChecks: return "custom";
+    case AssetChecks: return "assets";
+    default: return "";
+    }
+}
+
+QString LaunchPlan::findInvalidFile(qint64* groupTimes) {
+
+    FingerprintCache* cache = FingerprintCache::instance();
+    QElapsedTimer timer;
+
+    for (int group = 0; group < CheckGroupCount; group++) {
+        timer.start();
+        if (groupTimes != 0) groupTimes[group] = 0;
+
+        foreach (Check check, checks[group]) {
+
+            // Hash calculated only if file changed since last verification
+            if (!cache->verify(check.first, check.second)) return check.first;
+        }
+
+        if (groupTimes != 0) groupTimes[group] = timer.elapsed();
+    }
+
+    return "";
+}
+
+QString LaunchPlan::getCacheFileName() {
+    return Settings::instance()->getVersionsDir(client) + "/" + version + "/launch_plan.dat";
+}
+
+bool LaunchPlan::resolve(QString client, QString version, QString java) {
+
+    Logger* logger = Logger::logger();
+    Settings* settings = Settings::instance();
+
+    this->client = client;
+    this->version = version;
+    this->java = java;
+
+    error = NoError;
+    errorString.clear();
+    cached = false;
+
+    QString versionPrefix = settings->getVersionsDir(client) + "/" + version + "/";
+
+    bool found;
+    QByteArray versionData = readIndex(versionPrefix + version + ".json", &found);
+    if (!found) {
+        error = IndexNotFound;
+        errorString = "can't open " + version + ".json";
+        logger->append("LaunchPlan", "Error: " + errorString + "\n");
+        return false;
+    }
+
+    QByteArray dataData = readIndex(versionPrefix + "data.json", &found);
+    if (!found) {
+        error = DataIndexNotFound;
+        errorString = "can't open data.json";
+        logger->append("LaunchPlan", "Error: " + errorString + "\n");
+        return false;
+    }
+
+    if (loadCache(versionData, dataData)) {
+        cached = true;
+        prepareArgFile();
+        return true;
+    }
+
+    if (!build()) {
+        logger->append("LaunchPlan", "Error: " + errorString + "\n");
+        return false;
+    }
+
+    // Assets index name is known only after resolving
+    QByteArray assetsData = readIndex(settings->getAssetsDir() + "/indexes/" + assetsId + ".json", &found);
+    saveCache(makeKey(versionData, dataData, assetsData));
+    prepareArgFile();
+    return true;
+}
+
+// Removes argument files of previous library sets (and classpath jars of older
+// launcher), except the current one
+static void removeArgFiles(QString versionPrefix, QString keep) {
+    QDir versionDir(versionPrefix);
+    foreach (QString name, versionDir.entryList(QStringList() << "classpath_*", QDir::Files)) {
+        if (versionDir.absoluteFilePath(name) != keep) QFile::remove(versionDir.absoluteFilePath(name));
+    }
+}
+
+// Java 9+ expands @argfile itself, so java.class.path stays the same as with -cp,
+// only the command line gets short. File is named by classpath hash, so it is
+// written only when libraries change. Java 8 (or not probed yet) gets plain -cp.
+void LaunchPlan::prepareArgFile() {
+
+    Logger* logger = Logger::logger();
+    QString versionPrefix = Settings::instance()->getVersionsDir(client) + "/" + version + "/";
+
+    JavaRegistry::Runtime runtime = JavaRegistry::instance()->getCachedRuntime(java);
+    if (!runtime.valid || runtime.major < 9) {
+        argFile = "";
+        return;
+    }
+
+    QByteArray hash = QCryptographicHash::hash(classpath.toUtf8(), QCryptographicHash::Sha1).toHex();
+    argFile = versionPrefix + "classpath_" + QString(hash.left(16)) + ".args";
+    if (QFile::exists(argFile)) return;
+
+    // Quoted argument, backslashes of windows paths must be escaped
+    QString quoted = classpath;
+    quoted.replace("\\", "\\\\").replace("\"", "\\\"");
+
+    QSaveFile file(argFile);
+    if (!file.open(QIODevice::WriteOnly)) {
+        logger->append("LaunchPlan", "Error: can't write argument file, using plain classpath\n");
+        argFile = "";
+        return;
+    }
+
+    // Java reads argument files in platform encoding
+    file.write(QString("-cp\n\"" + quoted + "\"\n").toLocal8Bit());
+    if (!file.commit()) {
+        logger->append("LaunchPlan", "Error: can't write argument file, using plain classpath\n");
+        argFile = "";
+        return;
+    }
+
+    removeArgFiles(versionPrefix, argFile);
+
+    logger->append("LaunchPlan", "Argument file created: " + argFile + "\n");
+}
+
+QByteArray LaunchPlan::makeKey(const QByteArray& versionData, const QByteArray& dataData, const QByteArray& assetsData) {
+
+    Settings* settings = Settings::instance();
+
+    QCryptographicHash key(QCryptographicHash::Sha1);
+    key.addData(QString(client + "/" + version + "/" + java + "/"
+                        + settings->getOsName() + "/" + settings->getWordSize() + "/"
+                        + settings->getOsVersion()).toUtf8());
+
+    key.addData(QCryptographicHash::hash(versionData, QCryptographicHash::Sha1));
+    key.addData(QCryptographicHash::hash(dataData, QCryptographicHash::Sha1));
+    key.addData(QCryptographicHash::hash(assetsData, QCryptographicHash::Sha1));
+
+    return key.result();
+}
+
+bool LaunchPlan::loadCache(const QByteArray& versionData, const QByteArray& dataData) {
+
+    QFile cacheFile(getCacheFileName());
+    if (!cacheFile.open(QIODevice::ReadOnly)) return false;
+
+    QDataStream in(&cacheFile);
+    in.setVersion(QDataStream::Qt_5_0);
+
+    quint32 magic, format;
+    QByteArray key;
+
+    in >> magic >> format;
+    if (magic != launchCacheMagic || format != launchCacheFormat) return false;
+
+    in >> assetsId >> key;
+    if (in.status() != QDataStream::Ok) return false;
+
+    bool found;
+    QByteArray assetsData = readIndex(Settings::instance()->getAssetsDir() + "/indexes/" + assetsId + ".json", &found);
+    if (!found) return false;
+
+    // Some of indexes changed since plan was resolved
+    if (key != makeKey(versionData, dataData, assetsData)) return false;
+
+    qint32 memory;
+    in >> classpath >> natives >> mainClass >> arguments >> memory;
+    memoryHint = memory;
+    for (int group = 0; group < CheckGroupCount; group++) in >> checks[group];
+
+    return in.status() == QDataStream::Ok;
+}
+
+void LaunchPlan::saveCache(const QByteArray& key) {
+
+    QSaveFile cacheFile(getCacheFileName());
+    if (!cacheFile.open(QIODevice::WriteOnly)) {
+        Logger::logger()->append("LaunchPlan", "Error: save plan: " + cacheFile.errorString() + "\n");
+        return;
+    }
+
+    QDataStream out(&cacheFile);
+    out.setVersion(QDataStream::Qt_5_0);
+
+    out << launchCacheMagic << launchCacheFormat << assetsId << key;
+    out << classpath << natives << mainClass << arguments << qint32(memoryHint);
+    for (int group = 0; group < CheckGroupCount; group++) out << checks[group];
+
+    if (!cacheFile.commit()) {
+        Logger::logger()->append("LaunchPlan", "Error: save plan: " + cacheFile.errorString() + "\n");
+    }
+}
+
+bool LaunchPlan::build() {
+
+    Settings* settings = Settings::instance();
+
+    InstallPlan plan;
+    if (!plan.resolve(client, version)) {
+        error = (plan.getError() == InstallPlan::IndexNotFound) ? IndexNotFound : IndexParseError;
+        errorString = plan.getErrorString();
+        return false;
+    }
+
+    if (!plan.hasDataIndex()) {
+        error = DataIndexNotFound;
+        errorString = "can't open data.json";
+        return false;
+    }
+
+    classpath.clear();
+    natives.clear();
+    for (int group = 0; group < CheckGroupCount; group++) checks[group].clear();
+
+    // Libraries, natives are extracted instead of classpath
+    QString classpathSeparator = (settings->getOsName() == "windows") ? ";" : ":";
+
+    foreach (InstallPlan::Artifact lib, plan.getArtifacts(InstallPlan::Library)) {
+        checks[LibraryChecks].append(Check(lib.path, lib.hash));
+
+        if (lib.native) {
+            Native native;
+            native.path = lib.path;
+            native.hash = lib.hash;
+            native.excludes = lib.excludes;
+            natives.append(native);
+        } else {
+            classpath += lib.path + classpathSeparator;
+        }
+    }
+
+    // Game jar
+    foreach (InstallPlan::Artifact mainJar, plan.getArtifacts(InstallPlan::MainJar)) {
+        checks[GameJarChecks].append(Check(mainJar.path, mainJar.hash));
+        classpath += mainJar.path;
+    }
+
+    foreach (InstallPlan::Artifact customFile, plan.getArtifacts(InstallPlan::CustomFile)) {
+        checks[CustomFileChecks].append(Check(customFile.path, customFile.hash));
+    }
+
+    mainClass = plan.getMainClass();
+    if (mainClass.isEmpty()) {
+        error = NoMainClass;
+        errorString = "can't read mainClass";
+        return false;
+    }
+
+    assetsId = plan.getAssetsId();
+    if (assetsId.isEmpty()) {
+        error = NoAssets;
+        errorString = "can't read assets index name";
+        return false;
+    }
+
+    if (!plan.hasAssetsIndex()) {
+        error = AssetsIndexNotFound;
+        errorString = "can't open assets index file";
+        return false;
+    }
+
+    foreach (InstallPlan::Artifact asset, plan.getArtifacts(InstallPlan::Asset)) {
+        checks[AssetChecks].append(Check(asset.path, asset.hash));
+    }
+
+    arguments = plan.getMinecraftArguments();
+    memoryHint = plan.getMemoryHint();
+    if (arguments.isEmpty()) {
+        error = NoArguments;
+        errorString = "can't read minecraft arguments";
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,76 @@
+#ifndef LAUNCHPLAN_H
+#define LAUNCHPLAN_H
+
+#include <QtCore>
+
+// Everything needed to start the game, resolved from install plan once and
+// cached next to the version index. Cache is keyed by hashes of indexes,
+// so unchanged indexes are not parsed again on the next launch.
+class LaunchPlan
+{
+public:
+    enum Error { NoError, IndexNotFound, DataIndexNotFound, AssetsIndexNotFound,
+                 IndexParseError, NoMainClass, NoAssets, NoArguments };
+
+    // File to verify before launch
+    typedef QPair<QString, QString> Check; // Local file name, SHA-1 or "mutable"
+    enum CheckGroup { LibraryChecks, GameJarChecks, CustomFileChecks, AssetChecks, CheckGroupCount };
+
+    // Native library to extract
+    struct Native {
+        QString path;
+        QString hash;
+        QStringList excludes;
+    };
+
+    LaunchPlan();
+
+    bool resolve(QString client, QString version, QString java);
+
+    Error getError();
+    QString getErrorString();
+    bool isCached();
+
+    QString getJava();
+    QString getClasspath();
+    QString getArgFile(); // Java argument file with classpath, or empty string for plain -cp
+    QList<Native> getNatives();
+    QString getMainClass();
+    QString getAssetsId();
+    QString getArguments(); // With ${...} placeholders
+    int getMemoryHint();    // Recommended heap size in MiB, 0 if not specified
+    QList<Check> getChecks();
+    QList<Check> getChecks(CheckGroup group);
+    static QString getCheckGroupName(CheckGroup group);
+
+    // Returns first missing or broken file to check, or empty string.
+    // Time spent on each group is written to groupTimes[CheckGroupCount].
+    QString findInvalidFile(qint64* groupTimes = 0);
+
+private:
+    QString client;
+    QString version;
+
+    Error error;
+    QString errorString;
+    bool cached;
+
+    QString java;
+    QString classpath;
+    QString argFile;
+    QList<Native> natives;
+    QString mainClass;
+    QString assetsId;
+    QString arguments;
+    int memoryHint;
+    QList<Check> checks[CheckGroupCount];
+
+    QString getCacheFileName();
+    QByteArray makeKey(const QByteArray& versionData, const QByteArray& dataData, const QByteArray& assetsData);
+    bool loadCache(const QByteArray& versionData, const QByteArray& dataData);
+    void saveCache(const QByteArray& key);
+    bool build();
+    void prepareArgFile();
+};
+
+#endif // LAUNCHPLAN_H
@@ -40,6 +40,9 @@ void Logger::append(QString sender, QString text)
 {
     QString prefix = "(" + QTime::currentTime().toString("hh:mm:ss") + ") " + sender + " >> ";
 
+    // Workers (natives extraction) log concurrently
+    QMutexLocker locker(&mutex);
+
     QTextStream(stdout) << prefix << text;
     QTextStream textout(logFile);
     if (logFile != 0) textout << prefix << text;
@@ -12,6 +12,7 @@ private:
     static Logger* myInstance;
 
     QFile* logFile;
+    QMutex mutex;
 
     Logger& operator=(Logger const&);
     Logger(Logger const&);
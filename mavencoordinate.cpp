@@ -0,0 +1,73 @@
+#include "mavencoordinate.h"
+
+// Version indexes are parsed from launcher and prewarmer threads
+static QMutex groupPathsMutex;
+static QHash<QString, QString> groupPaths;
+
+static QString internGroupPath(const QString& group) {
+
+    QMutexLocker locker(&groupPathsMutex);
+
+    QHash<QString, QString>::const_iterator it = groupPaths.constFind(group);
+    if (it != groupPaths.constEnd()) return *it;
+
+    QString path = group;
+    path.replace('.', '/');
+    groupPaths.insert(group, path);
+    return path;
+}
+
+MavenCoordinate::MavenCoordinate() {
+    valid = false;
+}
+
+MavenCoordinate::MavenCoordinate(QString coordinate) {
+
+    valid = false;
+
+    int at = coordinate.lastIndexOf('@');
+    extension = (at == -1) ? QString("jar") : coordinate.mid(at + 1);
+    if (at != -1) coordinate.truncate(at);
+
+    // Single pass over separators instead of split()
+    int first = coordinate.indexOf(':');
+    int second = (first == -1) ? -1 : coordinate.indexOf(':', first + 1);
+    if (second == -1 || extension.isEmpty()) return;
+
+    int third = coordinate.indexOf(':', second + 1);
+    if (third != -1 && coordinate.indexOf(':', third + 1) != -1) return;
+
+    group = coordinate.left(first);
+    name = coordinate.mid(first + 1, second - first - 1);
+    version = (third == -1) ? coordinate.mid(second + 1) : coordinate.mid(second + 1, third - second - 1);
+    classifier = (third == -1) ? QString() : coordinate.mid(third + 1);
+
+    if (group.isEmpty() || name.isEmpty() || version.isEmpty()) return;
+
+    groupPath = internGroupPath(group);
+    valid = true;
+}
+
+bool MavenCoordinate::isValid() const { return valid; }
+
+QString MavenCoordinate::getGroup() const { return group; }
+QString MavenCoordinate::getName() const { return name; }
+QString MavenCoordinate::getVersion() const { return version; }
+QString MavenCoordinate::getClassifier() const { return classifier; }
+QString MavenCoordinate::getExtension() const { return extension; }
+
+QString MavenCoordinate::getPath(QString classifier) const {
+
+    if (!valid) return QString();
+    if (classifier.isEmpty()) classifier = this->classifier;
+
+    QString path;
+    path.reserve(groupPath.size() + 2 * name.size() + 2 * version.size() + classifier.size() + extension.size() + 6);
+
+    path.append(groupPath).append('/').append(name).append('/').append(version).append('/')
+            .append(name).append('-').append(version);
+    if (!classifier.isEmpty()) path.append('-').append(classifier);
+    path.append('.').append(extension);
+
+    return path;
+}
@@ -0,0 +1,36 @@
+#ifndef MAVENCOORDINATE_H
+#define MAVENCOORDINATE_H
+
+#include <QtCore>
+
+// Maven coordinate of library: <group>:<name>:<version>[:<classifier>][@<extension>].
+// Parsed once, group paths are interned, so libraries of the same group share them.
+class MavenCoordinate
+{
+public:
+    MavenCoordinate();
+    explicit MavenCoordinate(QString coordinate);
+
+    bool isValid() const;
+
+    QString getGroup() const;
+    QString getName() const;
+    QString getVersion() const;
+    QString getClassifier() const;
+    QString getExtension() const; // "jar" if not specified
+
+    // Relative path in repository: <group path>/<name>/<version>/<name>-<version>[-<classifier>].<extension>.
+    // Classifier argument, if not empty, replaces classifier of the coordinate (used for natives).
+    QString getPath(QString classifier = QString()) const;
+
+private:
+    bool valid;
+    QString group;
+    QString groupPath;
+    QString name;
+    QString version;
+    QString classifier;
+    QString extension;
+};
+
+#endif // MAVENCOORDINATE_H
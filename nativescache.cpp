@@ -0,0 +1,149 @@
+#include "nativescache.h"
+
+#include "settings.h"
+#include "logger.h"
+#include "util.h"
+#include "fingerprintcache.h"
+
+#include <QtConcurrent>
+#include <QCryptographicHash>
+#include <QSaveFile>
+
+// Native jar to extract into shared natives cache
+struct NativesJob {
+    QString jarPath;
+    QString hash;
+    QStringList excludes;
+    QString nativesDir;
+};
+
+// Runs in worker threads, returns error string
+static QString extractNatives(const NativesJob& job) {
+
+    // Broken jar must not be cached under the hash of a good one
+    if (!FingerprintCache::instance()->verify(job.jarPath, job.hash)) return "bad checksum of " + job.jarPath;
+
+    // Extract into temporary directory, so interrupted extraction is never used
+    QString partDir = job.nativesDir + ".part";
+    Util::removeAll(partDir);
+    if (!QDir().mkpath(partDir)) return "can't create " + partDir;
+
+    QString error;
+    if (!Util::unzipArchive(job.jarPath, partDir, job.excludes, &error)) {
+        Util::removeAll(partDir);
+        return error;
+    }
+
+    if (!QDir().rename(partDir, job.nativesDir)) {
+        Util::removeAll(partDir);
+        if (!QFileInfo(job.nativesDir).isDir()) return "can't rename " + partDir;
+    }
+
+    return "";
+}
+
+bool NativesCache::prepare(QList<LaunchPlan::Native> natives, QStringList* dirs, QString* errorString) {
+
+    QString nativesRoot = Settings::instance()->getNativesDir();
+    QList<NativesJob> jobs;
+
+    foreach (LaunchPlan::Native native, natives) {
+
+        QString hash = native.hash;
+        if (hash.isEmpty() || hash == "mutable") {
+            hash = FingerprintCache::instance()->getHash(native.path);
+            if (hash.isEmpty()) {
+                *errorString = "can't open " + native.path;
+                return false;
+            }
+        }
+
+        // Same jar may be extracted with different excludes by different versions
+        QString nativesDir = nativesRoot + "/" + hash;
+        if (!native.excludes.isEmpty()) {
+            QStringList excludes = native.excludes;
+            excludes.sort();
+            QByteArray excludesHash = QCryptographicHash::hash(excludes.join("\n").toUtf8(),
+                                                               QCryptographicHash::Sha1).toHex();
+            nativesDir += "_" + QString(excludesHash.left(8));
+        }
+        dirs->append(nativesDir);
+
+        if (!QFileInfo(nativesDir).isDir()) {
+            NativesJob job;
+            job.jarPath = native.path;
+            job.hash = hash;
+            job.excludes = native.excludes;
+            job.nativesDir = nativesDir;
+            jobs.append(job);
+        }
+    }
+
+    if (jobs.isEmpty()) return true;
+
+    Logger::logger()->append("NativesCache", "Extracting natives of " + QString::number(jobs.size()) + " jars\n");
+
+    foreach (QString error, QtConcurrent::blockingMapped(jobs, extractNatives)) {
+        if (!error.isEmpty()) {
+            *errorString = error;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void NativesCache::cleanup(QString client, QStringList dirs) {
+
+    Settings* settings = Settings::instance();
+    Logger* logger = Logger::logger();
+
+    QString nativesRoot = settings->getNativesDir();
+    QString clientsFileName = nativesRoot + "/clients.json";
+
+    // Natives were extracted into client directory before the shared cache
+    QString legacyDir = settings->getClientDir(client) + "/natives";
+    if (QFileInfo(legacyDir).isDir()) {
+        logger->append("NativesCache", "Removing old natives directory " + legacyDir + "\n");
+        Util::removeAll(legacyDir);
+    }
+
+    QJsonObject clients;
+    QFile clientsFile(clientsFileName);
+    if (clientsFile.open(QIODevice::ReadOnly)) {
+        clients = QJsonDocument::fromJson(clientsFile.readAll()).object();
+        clientsFile.close();
+    }
+
+    QJsonArray names;
+    foreach (QString dir, dirs) {
+        names.append(QFileInfo(dir).fileName());
+    }
+    clients[client] = names;
+
+    QSaveFile saveFile(clientsFileName);
+    if (!saveFile.open(QIODevice::WriteOnly)) return;
+    saveFile.write(QJsonDocument(clients).toJson(QJsonDocument::Compact));
+    if (!saveFile.commit()) return;
+
+    QSet<QString> used;
+    foreach (QJsonValue clientNames, clients) {
+        foreach (QJsonValue name, clientNames.toArray()) {
+            used.insert(name.toString());
+        }
+    }
+
+    int removed = 0;
+    QDir rootDir(nativesRoot);
+    foreach (QString name, rootDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+        // Extraction of prewarmer may be in progress
+        if (name.endsWith(".part") || used.contains(name)) continue;
+
+        Util::removeAll(rootDir.absoluteFilePath(name));
+        removed++;
+    }
+
+    if (removed > 0) {
+        logger->append("NativesCache", "Removed " + QString::number(removed) + " unused natives directories\n");
+    }
+}
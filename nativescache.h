@@ -0,0 +1,23 @@
+#ifndef NATIVESCACHE_H
+#define NATIVESCACHE_H
+
+#include <QtCore>
+
+#include "launchplan.h"
+
+// Natives of each native jar are extracted once into <base>/natives/<sha1>
+// (with suffix of excludes hash, if any) and shared by all clients and launches.
+// Directories used by the last launch of each client are kept in natives/clients.json.
+namespace NativesCache {
+
+// Returns directories with extracted natives, only natives of changed jars
+// are extracted (concurrently). Blocks until extraction is finished.
+bool prepare(QList<LaunchPlan::Native> natives, QStringList* dirs, QString* errorString);
+
+// Records directories of successful launch, removes ones not used by any client
+// and natives directory of the client made by older launcher
+void cleanup(QString client, QStringList dirs);
+
+}
+
+#endif // NATIVESCACHE_H
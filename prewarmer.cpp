@@ -0,0 +1,200 @@
+#include "prewarmer.h"
+
+#include "settings.h"
+#include "util.h"
+#include "storewatcher.h"
+#include "nativescache.h"
+#include "versionscatalog.h"
+#include "indexcache.h"
+#include "gameindex.h"
+#include "javaregistry.h"
+#include "resourcecontrols.h"
+
+#include <QSaveFile>
+
+// Indexes on update server may change, so old results are not used
+static const qint64 prewarmMaxAge = 10 * 60 * 1000;
+
+// Writes index only if it's changed, so store watcher is not disturbed
+static void refreshIndex(QString url, QString fileName) {
+
+    Reply reply = Util::makeGet(url);
+    if (!reply.isOK()) return;
+
+    QFile oldFile(fileName);
+    if (oldFile.open(QIODevice::ReadOnly)) {
+        bool same = (oldFile.readAll() == reply.reply());
+        oldFile.close();
+        if (same) return;
+    }
+
+    QDir().mkpath(QFileInfo(fileName).absolutePath());
+
+    QSaveFile file(fileName);
+    if (file.open(QIODevice::WriteOnly)) {
+        file.write(reply.reply());
+        file.commit();
+    }
+}
+
+Prewarmer::Prewarmer(QObject *parent) :
+    QThread(parent)
+{
+    logger = Logger::logger();
+
+    target.online = false;
+    ready = false;
+    generation = 0;
+    changes = 0;
+}
+
+Prewarmer::~Prewarmer() {
+    cancel();
+    wait();
+}
+
+QString Prewarmer::makeKey(const Target& target) {
+    return target.client + "/" + target.version + "/" + target.java + "/" + (target.online ? "online" : "offline");
+}
+
+void Prewarmer::setTarget(Target target) {
+    this->target = target;
+}
+
+QString Prewarmer::getKey() {
+    return makeKey(target);
+}
+
+void Prewarmer::cancel() {
+    canceled.storeRelease(1);
+}
+
+bool Prewarmer::isCanceled() {
+    return canceled.loadAcquire() != 0;
+}
+
+bool Prewarmer::isReady() {
+    return !isRunning() && ready && readyTimer.elapsed() < prewarmMaxAge;
+}
+
+bool Prewarmer::isFresh() {
+
+    if (!isReady()) return false;
+
+    StoreWatcher* watcher = StoreWatcher::instance();
+    if (!watcher->isLive() || watcher->getGeneration() != generation || watcher->getChanges() != changes) {
+        return false;
+    }
+
+    // Natives cache is out of watched store
+    foreach (QString dir, libpath) {
+        if (!QFileInfo(dir).isDir()) return false;
+    }
+
+    return true;
+}
+
+QString Prewarmer::getGameVersion() { return gameVersion; }
+LaunchPlan Prewarmer::getPlan() { return plan; }
+QStringList Prewarmer::getLibpath() { return libpath; }
+
+bool Prewarmer::resolveVersion() {
+
+    gameVersion = target.version;
+    if (gameVersion != "latest") return true;
+
+    if (!target.online) {
+        gameVersion = VersionsCatalog::findLatest(target.client);
+        return !gameVersion.isEmpty();
+    }
+
+    Reply versionReply = Util::makeGet(target.versionsUrl);
+    if (!versionReply.isOK()) return false;
+
+    QJsonObject latest = QJsonDocument::fromJson(versionReply.reply()).object()["latest"].toObject();
+    if (!latest["release"].isString()) return false;
+
+    gameVersion = latest["release"].toString();
+    return true;
+}
+
+void Prewarmer::refreshIndexes() {
+
+    Settings* settings = Settings::instance();
+
+    QString versionDir = settings->getVersionsDir(target.client) + "/" + gameVersion + "/";
+    QString versionUrl = settings->getVersionUrl(target.client, gameVersion);
+
+    refreshIndex(versionUrl + gameVersion + ".json", versionDir + gameVersion + ".json");
+    VersionsCatalog::update(target.client, gameVersion);
+    if (isCanceled()) return;
+
+    refreshIndex(versionUrl + "data.json", versionDir + "data.json");
+    if (isCanceled()) return;
+
+    GameIndex::VersionIndex versionIndex = IndexCache::readVersion(versionDir + gameVersion + ".json");
+
+    if (!versionIndex.assets.isEmpty()) {
+        QString assets = versionIndex.assets;
+        refreshIndex(settings->getAssetsUrl() + "indexes/" + assets + ".json",
+                     settings->getAssetsDir() + "/indexes/" + assets + ".json");
+    }
+}
+
+void Prewarmer::run() {
+
+    canceled.storeRelease(0);
+    ready = false;
+    libpath.clear();
+
+    if (Settings::instance()->loadIdleIoState()) ResourceControls::setIdleIoPriority();
+
+    QElapsedTimer timer;
+    timer.start();
+
+    logger->append("Prewarmer", "Preparing launch of " + getKey() + "\n");
+
+    // Any change made after this moment invalidates results. Caches written
+    // by the run itself (catalog, plans, compiled indexes) are ignored by watcher.
+    StoreWatcher* watcher = StoreWatcher::instance();
+    generation = watcher->getGeneration();
+    changes = watcher->getChanges();
+
+    if (!resolveVersion()) {
+        logger->append("Prewarmer", "Can't resolve version, skipped\n");
+        return;
+    }
+    if (isCanceled()) return;
+
+    if (target.online) refreshIndexes();
+    if (isCanceled()) return;
+
+    QString java = target.java;
+    if (java.isEmpty()) java = JavaRegistry::instance()->selectJava(VersionsCatalog::getJavaMajor(target.client, gameVersion));
+
+    if (!plan.resolve(target.client, gameVersion, java)) {
+        logger->append("Prewarmer", "Can't resolve launch plan, skipped\n");
+        return;
+    }
+    if (isCanceled()) return;
+
+    QString invalidFile = plan.findInvalidFile();
+    if (!invalidFile.isEmpty()) {
+        logger->append("Prewarmer", "Missing or bad file " + invalidFile + ", skipped\n");
+        return;
+    }
+    if (isCanceled()) return;
+
+    QString error;
+    if (!NativesCache::prepare(plan.getNatives(), &libpath, &error)) {
+        logger->append("Prewarmer", "Can't prepare natives: " + error + ", skipped\n");
+        return;
+    }
+    if (isCanceled()) return;
+
+    ready = true;
+    readyTimer.start();
+
+    logger->append("Prewarmer", "Launch of " + getKey() + " prepared in "
+                   + QString::number(timer.elapsed()) + " ms\n");
+}
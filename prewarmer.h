@@ -0,0 +1,64 @@
+#ifndef PREWARMER_H
+#define PREWARMER_H
+
+#include <QtCore>
+
+#include "launchplan.h"
+#include "logger.h"
+
+// Low priority speculative launch preparation for the active client:
+// resolves version, refreshes indexes, checks files and prepares natives,
+// so Play has only to login and spawn the game.
+class Prewarmer : public QThread
+{
+    Q_OBJECT
+public:
+    struct Target {
+        QString client;
+        QString version;     // May be 'latest'
+        QString java;
+        bool online;
+        QString versionsUrl; // List of versions, for 'latest' resolution
+    };
+
+    explicit Prewarmer(QObject *parent = 0);
+    ~Prewarmer();
+
+    static QString makeKey(const Target& target);
+
+    void setTarget(Target target);
+    QString getKey();
+    void cancel();
+
+    // Results of the last run for target
+    bool isReady();
+    bool isFresh(); // Nothing changed in the game store since preparation
+    QString getGameVersion();
+    LaunchPlan getPlan();
+    QStringList getLibpath();
+
+protected:
+    void run();
+
+private:
+    Logger* logger;
+
+    Target target;
+    QAtomicInt canceled;
+
+    bool ready;
+    QString gameVersion;
+    LaunchPlan plan;
+    QStringList libpath;
+
+    QElapsedTimer readyTimer;
+    quint64 generation;
+    quint64 changes;
+
+    bool isCanceled();
+    bool resolveVersion();
+    void refreshIndexes();
+
+};
+
+#endif // PREWARMER_H
@@ -1,5 +1,10 @@
 #include "reply.h"
 
+Reply::Reply()
+{
+    status = false;
+}
+
 Reply::Reply(bool state, QString errStr, QByteArray data)
 {
     status = state;
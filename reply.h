@@ -6,6 +6,7 @@
 class Reply
 {
 public:
+    Reply(); // Empty reply, used as result of background requests
     Reply(bool state, QString errStr, QByteArray data);
 
     bool isOK();
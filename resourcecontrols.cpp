@@ -0,0 +1,146 @@
+#include "resourcecontrols.h"
+#include "logger.h"
+
+#ifdef Q_OS_LINUX
+#include <sched.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+
+// From linux/ioprio.h, not exported by glibc
+#define IOPRIO_CLASS_SHIFT 13
+#define IOPRIO_CLASS_IDLE 3
+#define IOPRIO_WHO_PROCESS 1
+#endif
+
+// Result of systemd-run probe, checked once per launcher run
+static int cgroupState = -1;
+
+static bool isCgroupAvailable() {
+
+#ifdef Q_OS_LINUX
+    if (cgroupState != -1) return cgroupState == 1;
+    cgroupState = 0;
+
+    Logger* logger = Logger::logger();
+
+    // Unified hierarchy and a user manager able to create scopes are needed
+    if (!QFile::exists("/sys/fs/cgroup/cgroup.controllers")) {
+        logger->append("ResourceControls", "cgroup v2 is not mounted\n");
+        return false;
+    }
+
+    QString systemdRun = QStandardPaths::findExecutable("systemd-run");
+    if (systemdRun.isEmpty()) {
+        logger->append("ResourceControls", "systemd-run is not found\n");
+        return false;
+    }
+
+    QProcess probe;
+    probe.start(systemdRun, QStringList() << "--user" << "--scope" << "--quiet" << "true");
+    if (!probe.waitForFinished(5000) || probe.exitStatus() != QProcess::NormalExit || probe.exitCode() != 0) {
+        logger->append("ResourceControls", "Can't create user scope: " + QString::fromLocal8Bit(probe.readAllStandardError()) + "\n");
+        probe.kill();
+        probe.waitForFinished();
+        return false;
+    }
+
+    cgroupState = 1;
+    return true;
+#else
+    return false;
+#endif
+}
+
+namespace ResourceControls {
+
+bool parseCpuList(QString text, QList<int>* cpus) {
+
+    cpus->clear();
+
+    foreach (QString part, text.split(',', QString::SkipEmptyParts)) {
+        QStringList range = part.trimmed().split('-');
+        bool firstOk, lastOk;
+
+        int first = range[0].toInt(&firstOk);
+        int last = (range.size() == 2) ? range[1].toInt(&lastOk) : first;
+        if (range.size() == 1) lastOk = firstOk;
+
+        if (range.size() > 2 || !firstOk || !lastOk || first < 0 || last < first) {
+            cpus->clear();
+            return false;
+        }
+
+        for (int cpu = first; cpu <= last; cpu++) {
+            if (!cpus->contains(cpu)) cpus->append(cpu);
+        }
+    }
+
+    return true;
+}
+
+void wrapCommand(const Limits& limits, QString* program, QStringList* args) {
+
+    if (limits.memoryLimit <= 0) return;
+
+    Logger* logger = Logger::logger();
+
+    if (!isCgroupAvailable()) {
+        logger->append("ResourceControls", "Memory ceiling is not applied: cgroups are unavailable\n");
+        return;
+    }
+
+    // systemd-run execs the command, so the game stays our direct child
+    QStringList scopeArgs;
+    scopeArgs << "--user" << "--scope" << "--quiet"
+              << "--slice=ttyhlauncher.slice"
+              << "-p" << "MemoryMax=" + QString::number(limits.memoryLimit) + "M"
+              << "--" << *program << *args;
+
+    *program = QStandardPaths::findExecutable("systemd-run");
+    *args = scopeArgs;
+
+    logger->append("ResourceControls", "Game memory ceiling: " + QString::number(limits.memoryLimit) + " MiB\n");
+}
+
+void setIdleIoPriority() {
+
+#ifdef Q_OS_LINUX
+    // I/O priority is per thread on Linux, 0 means calling thread
+    if (syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, IOPRIO_CLASS_IDLE << IOPRIO_CLASS_SHIFT) != 0) {
+        Logger::logger()->append("ResourceControls", "Can't set idle I/O priority\n");
+    }
+#endif
+}
+
+}
+
+LimitedProcess::LimitedProcess(QObject *parent) :
+    QProcess(parent)
+{
+    limits.nice = 0;
+    limits.memoryLimit = 0;
+}
+
+void LimitedProcess::setLimits(const ResourceControls::Limits& limits) {
+    this->limits = limits;
+}
+
+// Runs in forked child, only async-signal-safe calls are allowed
+void LimitedProcess::setupChildProcess() {
+
+#ifdef Q_OS_LINUX
+    if (!limits.cpus.isEmpty()) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int i = 0; i < limits.cpus.size(); i++) {
+            if (limits.cpus.at(i) < CPU_SETSIZE) CPU_SET(limits.cpus.at(i), &set);
+        }
+        sched_setaffinity(0, sizeof(set), &set);
+    }
+
+    if (limits.nice != 0) {
+        setpriority(PRIO_PROCESS, 0, limits.nice);
+    }
+#endif
+}
@@ -0,0 +1,44 @@
+#ifndef RESOURCECONTROLS_H
+#define RESOURCECONTROLS_H
+
+#include <QtCore>
+
+// Scheduling and memory limits of the game process and I/O priority of
+// launcher background work. Linux only, elsewhere limits are ignored.
+namespace ResourceControls {
+
+struct Limits {
+    QList<int> cpus;    // Allowed cores, all if empty
+    int nice;           // Nice value, 0 keeps launcher one
+    int memoryLimit;    // Memory ceiling in MiB, 0 for no limit
+};
+
+// Parses list like "0-3,6", returns false on bad syntax
+bool parseCpuList(QString text, QList<int>* cpus);
+
+// Puts game command into its own cgroup v2 scope with memory ceiling
+// (through systemd-run), leaves command as is if cgroups are unavailable
+void wrapCommand(const Limits& limits, QString* program, QStringList* args);
+
+// Moves I/O of the calling thread to idle class
+void setIdleIoPriority();
+
+}
+
+// Applies core affinity and nice value in the child before exec,
+// so all JVM threads inherit them
+class LimitedProcess : public QProcess
+{
+public:
+    explicit LimitedProcess(QObject *parent = 0);
+
+    void setLimits(const ResourceControls::Limits& limits);
+
+protected:
+    void setupChildProcess();
+
+private:
+    ResourceControls::Limits limits;
+};
+
+#endif // RESOURCECONTROLS_H
@@ -20,6 +20,8 @@ const QString Settings::launcherVersion = "0.9";
 
 // Master-server links
 const QString Settings::authUrl          = "https://master.ttyh.ru/index.php?act=login";
+const QString Settings::validateUrl      = "https://master.ttyh.ru/index.php?act=validate";
+const QString Settings::refreshUrl       = "https://master.ttyh.ru/index.php?act=refresh";
 const QString Settings::changePasswrdUrl = "https://master.ttyh.ru/index.php?act=chpass";
 const QString Settings::skinUploadUrl    = "https://master.ttyh.ru/index.php?act=setskin";
 const QString Settings::feedbackUrl      = "https://master.ttyh.ru/index.php?act=feedback";
@@ -42,6 +44,8 @@ Settings::Settings() : QObject()
     QDir(configPath).mkpath(configPath);
 
     settings = new QSettings(configPath + "/config.ini", QSettings::IniFormat);
+
+    osVersion = detectOsVersion();
 }
 
 void Settings::loadClientList() {
@@ -135,7 +139,10 @@ QString Settings::getVersionsUrl() {
 }
 
 QString Settings::getVersionUrl(QString version) {
-    QString client = getClientStrId(loadActiveClientId());
+    return getVersionUrl(getClientStrId(loadActiveClientId()), version);
+}
+
+QString Settings::getVersionUrl(QString client, QString version) {
     return updateServer + "/" + client + "/" + version + "/";
 }
 
@@ -244,6 +251,9 @@ void Settings::saveMaximizedState(bool state) { settings->setValue("launcher/win
 bool Settings::loadOfflineModeState() { return settings->value("launcher/offline_mode", false).toBool(); }
 void Settings::saveOfflineModeState(bool offlineState) { settings->setValue("launcher/offline_mode", offlineState); }
 
+bool Settings::loadIdleIoState() { return settings->value("launcher/idle_io", true).toBool(); }
+void Settings::saveIdleIoState(bool state) { settings->setValue("launcher/idle_io", state); }
+
 // Client settings
 QString Settings::loadClientVersion() {
     int cid = loadActiveClientId();
@@ -295,19 +305,87 @@ void Settings::saveClientJavaArgs(QString args) {
     settings->setValue("client-" + getClientStrId(cid) + "/args", args);
 }
 
+bool Settings::loadClientCdsState() {
+    int cid = loadActiveClientId();
+    return settings->value("client-" + getClientStrId(cid) + "/use_cds", false).toBool();
+}
+
+void Settings::saveClientCdsState(bool state) {
+    int cid = loadActiveClientId();
+    settings->setValue("client-" + getClientStrId(cid) + "/use_cds", state);
+}
+
+bool Settings::loadClientPerfProfileState() {
+    int cid = loadActiveClientId();
+    return settings->value("client-" + getClientStrId(cid) + "/perf_profile", false).toBool();
+}
+
+void Settings::saveClientPerfProfileState(bool state) {
+    int cid = loadActiveClientId();
+    settings->setValue("client-" + getClientStrId(cid) + "/perf_profile", state);
+}
+
+bool Settings::loadClientResourcesState() {
+    int cid = loadActiveClientId();
+    return settings->value("client-" + getClientStrId(cid) + "/limit_resources", false).toBool();
+}
+
+void Settings::saveClientResourcesState(bool state) {
+    int cid = loadActiveClientId();
+    settings->setValue("client-" + getClientStrId(cid) + "/limit_resources", state);
+}
+
+QString Settings::loadClientCpus() {
+    int cid = loadActiveClientId();
+    return settings->value("client-" + getClientStrId(cid) + "/cpus", "").toString();
+}
+
+void Settings::saveClientCpus(QString cpus) {
+    int cid = loadActiveClientId();
+    settings->setValue("client-" + getClientStrId(cid) + "/cpus", cpus);
+}
+
+int Settings::loadClientNice() {
+    int cid = loadActiveClientId();
+    return settings->value("client-" + getClientStrId(cid) + "/nice", 0).toInt();
+}
+
+void Settings::saveClientNice(int nice) {
+    int cid = loadActiveClientId();
+    settings->setValue("client-" + getClientStrId(cid) + "/nice", nice);
+}
+
+int Settings::loadClientMemoryLimit() {
+    int cid = loadActiveClientId();
+    return settings->value("client-" + getClientStrId(cid) + "/memory_limit", 0).toInt();
+}
+
+void Settings::saveClientMemoryLimit(int limit) {
+    int cid = loadActiveClientId();
+    settings->setValue("client-" + getClientStrId(cid) + "/memory_limit", limit);
+}
+
 // Directories
 QString Settings::getBaseDir() {
     return dataPath;
 }
 
 QString Settings::getClientDir() {
-    return dataPath + "/client_" + getClientStrId(loadActiveClientId());
+    return getClientDir(getClientStrId(loadActiveClientId()));
+}
+
+QString Settings::getClientDir(QString client) {
+    return dataPath + "/client_" + client;
 }
 
 QString Settings::getClientPrefix(QString version) {
     return getClientDir() + "/prefixes/" + version;
 }
 
+QString Settings::getClientPrefix(QString client, QString version) {
+    return getClientDir(client) + "/prefixes/" + version;
+}
+
 QString Settings::getAssetsDir() {
     return dataPath + "/assets";
 }
@@ -320,8 +398,12 @@ QString Settings::getVersionsDir() {
     return getClientDir() + "/versions";
 }
 
+QString Settings::getVersionsDir(QString client) {
+    return getClientDir(client) + "/versions";
+}
+
 QString Settings::getNativesDir() {
-    return getClientDir() + "/natives";
+    return dataPath + "/natives";
 }
 
 QString Settings::getConfigDir() {
@@ -342,6 +424,10 @@ QString Settings::getOsName() {
 }
 
 QString Settings::getOsVersion() {
+    return osVersion;
+}
+
+QString Settings::detectOsVersion() {
 #ifdef Q_OS_WIN
     switch (QSysInfo::WindowsVersion) {
         case QSysInfo::WV_95:           return "95, OMFG!";
@@ -370,17 +456,16 @@ QString Settings::getOsVersion() {
 #endif
 
 #ifdef Q_OS_LINUX
-    QProcess* lsbRelease = new QProcess(this);
-    lsbRelease->start("lsb_release", QStringList() << "-d");
+    QProcess lsbRelease;
+    lsbRelease.start("lsb_release", QStringList() << "-d");
 
-    if (!lsbRelease->waitForStarted())  return "NO_LSB_DISTRO";
-    if (!lsbRelease->waitForFinished()) return "ERROR";
+    if (!lsbRelease.waitForStarted())  return "NO_LSB_DISTRO";
+    if (!lsbRelease.waitForFinished()) return "ERROR";
 
     // Get value from output: "Description:\t<value>\n"
-    QString releaseInfo = lsbRelease->readLine().split('\t').last();
+    QString releaseInfo = lsbRelease.readLine().split('\t').last();
     releaseInfo = releaseInfo.split('\n').first();
 
-    delete lsbRelease;
     return releaseInfo;
 #endif
 }
@@ -12,6 +12,8 @@ public:
     static Settings* instance();
 
     static const QString authUrl;
+    static const QString validateUrl;
+    static const QString refreshUrl;
     static const QString changePasswrdUrl;
     static const QString skinUploadUrl;
     static const QString feedbackUrl;
@@ -34,10 +36,15 @@ private:
     QString configPath;
     QString updateServer;
 
+    // Detected once, used by cache keys and library rules on any thread
+    QString osVersion;
+    QString detectOsVersion();
+
 public:
     // Update URLs
     QString getVersionsUrl();
     QString getVersionUrl(QString version);
+    QString getVersionUrl(QString client, QString version);
     QString getLibsUrl();
     QString getAssetsUrl();
 
@@ -56,10 +63,13 @@ public:
     // Directories
     QString getBaseDir();
     QString getClientDir();
+    QString getClientDir(QString client);
     QString getClientPrefix(QString version);
+    QString getClientPrefix(QString client, QString version);
     QString getAssetsDir();
     QString getLibsDir();
     QString getVersionsDir();
+    QString getVersionsDir(QString client);
     QString getNativesDir();
     QString getConfigDir();
 
@@ -84,6 +94,9 @@ public:
     void saveOfflineModeState(bool offlineState);
     bool loadOfflineModeState();
 
+    void saveIdleIoState(bool state);
+    bool loadIdleIoState();
+
     // Client settings
     QString loadClientVersion();
     void saveClientVersion(QString strid);
@@ -100,6 +113,24 @@ public:
     QString loadClientJavaArgs();
     void saveClientJavaArgs(QString args);
 
+    bool loadClientCdsState();
+    void saveClientCdsState(bool state);
+
+    bool loadClientPerfProfileState();
+    void saveClientPerfProfileState(bool state);
+
+    bool loadClientResourcesState();
+    void saveClientResourcesState(bool state);
+
+    QString loadClientCpus();
+    void saveClientCpus(QString cpus);
+
+    int loadClientNice();
+    void saveClientNice(int nice);
+
+    int loadClientMemoryLimit();
+    void saveClientMemoryLimit(int limit);
+
     bool loadClientFullscreenState();
     void saveClientFullscreenState(bool state);
 
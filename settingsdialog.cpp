@@ -5,6 +5,9 @@
 #include <QDesktopServices>
 #include <QMessageBox>
 
+#include "versionscatalog.h"
+#include "resourcecontrols.h"
+
 SettingsDialog::SettingsDialog(QWidget *parent) :
     QDialog(parent),
     ui(new Ui::SettingsDialog)
@@ -122,18 +125,12 @@ void SettingsDialog::appendVersionList(QString reason) {
     logger->append("SettingsDialog", "Append local version list...\n");
     ui->stateEdit->setText(reason);
 
-    QString prefix = settings->getClientDir() + "/versions";
-    QDir verdir = QDir(prefix);
-    QStringList subdirs = verdir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
-    foreach (QString ver, subdirs) {
-        QFile* file = new QFile(prefix + "/" + ver + "/" + ver + ".json");
-        if (file->exists()) {
-            // Add to version list unique local versions
-            if (ui->versionCombo->findData(ver) == -1) {
-                ui->versionCombo->addItem(ver + " (локальная версия)", ver);
-            }
+    QStringList localVersions = VersionsCatalog::getVersions(settings->getClientStrId(settings->loadActiveClientId()));
+    foreach (QString ver, localVersions) {
+        // Add to version list unique local versions
+        if (ui->versionCombo->findData(ver) == -1) {
+            ui->versionCombo->addItem(ver + " (локальная версия)", ver);
         }
-        delete file;
     }
 
     int id = ui->versionCombo->findData(settings->loadClientVersion());
@@ -143,6 +140,13 @@ void SettingsDialog::appendVersionList(QString reason) {
 
 void SettingsDialog::saveSettings() {
 
+    QList<int> cpus;
+    if (!ResourceControls::parseCpuList(ui->cpusEdit->text(), &cpus)) {
+        QMessageBox::warning(this, "Неверные параметры", "Список ядер указывается так: 0-3,6");
+        logger->append("SettingsDialog", "Error: bad cpu list: " + ui->cpusEdit->text() + "\n");
+        return;
+    }
+
     int id = ui->versionCombo->currentIndex();
     QString strid = ui->versionCombo->itemData(id).toString();
     settings->saveClientVersion(strid);
@@ -151,6 +155,13 @@ void SettingsDialog::saveSettings() {
     settings->saveClientJava(ui->javapathEdit->text());
     settings->saveClientJavaArgsState(ui->argsBox->isChecked());
     settings->saveClientJavaArgs(ui->argsEdit->text());
+    settings->saveClientResourcesState(ui->resourcesBox->isChecked());
+    settings->saveClientCpus(ui->cpusEdit->text());
+    settings->saveClientNice(ui->niceSpinBox->value());
+    settings->saveClientMemoryLimit(ui->memorySpinBox->value());
+    settings->saveIdleIoState(ui->idleIoCheck->isChecked());
+    settings->saveClientPerfProfileState(ui->profileCheck->isChecked());
+    settings->saveClientCdsState(ui->cdsCheck->isChecked());
     settings->saveClientWindowGeometry(QRect(-1, -1, ui->widthSpinBox->value(), ui->heightSpinBox->value()));
     settings->saveClientSizeState(ui->sizeBox->isChecked());
     settings->saveClientFullscreenState(ui->fullscreenRadio->isChecked());
@@ -163,6 +174,13 @@ void SettingsDialog::saveSettings() {
     logger->append("SettingsDialog", "\tClientJava: " + ui->javapathEdit->text() + "\n");
     logger->append("SettingsDialog", "\tUseClientArgs: " + QString(ui->argsBox->isChecked() ? "true" : "false") + "\n");
     logger->append("SettingsDialog", "\tClientArgs: " + ui->argsEdit->text() + "\n");
+    logger->append("SettingsDialog", "\tLimitResources: " + QString(ui->resourcesBox->isChecked() ? "true" : "false") + "\n");
+    logger->append("SettingsDialog", "\tCpus: " + ui->cpusEdit->text() + "\n");
+    logger->append("SettingsDialog", "\tNice: " + QString::number(ui->niceSpinBox->value()) + "\n");
+    logger->append("SettingsDialog", "\tMemoryLimit: " + QString::number(ui->memorySpinBox->value()) + "\n");
+    logger->append("SettingsDialog", "\tIdleIo: " + QString(ui->idleIoCheck->isChecked() ? "true" : "false") + "\n");
+    logger->append("SettingsDialog", "\tUsePerfProfile: " + QString(ui->profileCheck->isChecked() ? "true" : "false") + "\n");
+    logger->append("SettingsDialog", "\tUseCds: " + QString(ui->cdsCheck->isChecked() ? "true" : "false") + "\n");
     logger->append("SettingsDialog", "\tUseCustomGeometry: " + QString(ui->sizeBox->isChecked() ? "true" : "false") + "\n");
     logger->append("SettingsDialog", "\tMinecraftGeometry: " +
                    QString::number(settings->loadClientWindowGeometry().width()) + "," +
@@ -180,6 +198,13 @@ void SettingsDialog::loadSettings() {
     ui->javapathEdit->setText(settings->loadClientJava());
     ui->argsBox->setChecked(settings->loadClientJavaArgsState());
     ui->argsEdit->setText(settings->loadClientJavaArgs());
+    ui->resourcesBox->setChecked(settings->loadClientResourcesState());
+    ui->cpusEdit->setText(settings->loadClientCpus());
+    ui->niceSpinBox->setValue(settings->loadClientNice());
+    ui->memorySpinBox->setValue(settings->loadClientMemoryLimit());
+    ui->idleIoCheck->setChecked(settings->loadIdleIoState());
+    ui->profileCheck->setChecked(settings->loadClientPerfProfileState());
+    ui->cdsCheck->setChecked(settings->loadClientCdsState());
     ui->widthSpinBox->setValue(settings->loadClientWindowGeometry().width());
     ui->heightSpinBox->setValue(settings->loadClientWindowGeometry().height());
     ui->sizeBox->setChecked(settings->loadClientSizeState());
@@ -199,6 +224,13 @@ void SettingsDialog::loadSettings() {
     logger->append("SettingsDialog", "\tClientJava: " + ui->javapathEdit->text() + "\n");
     logger->append("SettingsDialog", "\tUseClientArgs: " + QString(ui->argsBox->isChecked() ? "true" : "false") + "\n");
     logger->append("SettingsDialog", "\tClientArgs: " + ui->argsEdit->text() + "\n");
+    logger->append("SettingsDialog", "\tLimitResources: " + QString(ui->resourcesBox->isChecked() ? "true" : "false") + "\n");
+    logger->append("SettingsDialog", "\tCpus: " + ui->cpusEdit->text() + "\n");
+    logger->append("SettingsDialog", "\tNice: " + QString::number(ui->niceSpinBox->value()) + "\n");
+    logger->append("SettingsDialog", "\tMemoryLimit: " + QString::number(ui->memorySpinBox->value()) + "\n");
+    logger->append("SettingsDialog", "\tIdleIo: " + QString(ui->idleIoCheck->isChecked() ? "true" : "false") + "\n");
+    logger->append("SettingsDialog", "\tUsePerfProfile: " + QString(ui->profileCheck->isChecked() ? "true" : "false") + "\n");
+    logger->append("SettingsDialog", "\tUseCds: " + QString(ui->cdsCheck->isChecked() ? "true" : "false") + "\n");
     logger->append("SettingsDialog", "\tUseCustomGeometry: " + QString(ui->sizeBox->isChecked() ? "true" : "false") + "\n");
     logger->append("SettingsDialog", "\tMinecraftGeometry: " +
                    QString::number(ui->widthSpinBox->value())  + "," +
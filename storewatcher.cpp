@@ -0,0 +1,363 @@
+#include "storewatcher.h"
+#include "settings.h"
+
+#include <QSaveFile>
+
+#ifdef Q_OS_LINUX
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+
+static const quint32 watchMask = IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE
+                               | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO
+                               | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+#endif
+
+// Launcher's own caches (and QSaveFile temporaries of them), they are kept only in
+// versions directory of a client and directories of single versions, never in files/.
+// They are validated by their keys, and counting them as changes would make
+// every prewarm invalidate itself.
+static bool isLauncherCache(const QStringList& roots, const QString& dir, const QString& name) {
+
+    bool inVersions = false;
+    foreach (QString root, roots) {
+        if (!root.endsWith("/versions")) continue;
+        if (dir == root || QFileInfo(dir).path() == root) inVersions = true;
+    }
+    if (!inVersions) return false;
+
+    return name.startsWith("catalog.json") || name.contains(".json.bin")
+            || name.startsWith("install_plan") || name.startsWith("launch_plan")
+            || name.startsWith("classpath_");
+}
+
+StoreWatcher* StoreWatcher::myInstance = 0;
+StoreWatcher* StoreWatcher::instance() {
+    if (myInstance == 0) myInstance = new StoreWatcher();
+    return myInstance;
+}
+
+StoreWatcher::StoreWatcher(QObject *parent) :
+    QObject(parent)
+{
+    logger = Logger::logger();
+    journalFileName = Settings::instance()->getBaseDir() + "/store_journal.json";
+
+    live = false;
+    changes = 0;
+    generation = 1;
+    inotifyFd = -1;
+    notifier = 0;
+
+    // Load journal of previous session
+    QFile journalFile(journalFileName);
+    if (journalFile.open(QIODevice::ReadOnly)) {
+
+        QJsonParseError error;
+        QJsonDocument json = QJsonDocument::fromJson(journalFile.readAll(), &error);
+        journalFile.close();
+
+        if (error.error == QJsonParseError::NoError) {
+            QJsonObject journal = json.object();
+
+            // Watcher was not running while launcher was closed, so nothing
+            // verified before this moment can be trusted without stat
+            generation = quint64(journal["generation"].toDouble()) + 1;
+
+            foreach (QJsonValue path, journal["dirty"].toArray()) {
+                dirtyPaths.insert(path.toString());
+            }
+
+            QDateTime checkpoint = QDateTime::fromMSecsSinceEpoch(qint64(journal["checkpoint"].toDouble()));
+            logger->append("StoreWatcher", "Journal checkpoint: " + checkpoint.toString(Qt::ISODate)
+                           + ", dirty paths: " + QString::number(dirtyPaths.size()) + "\n");
+        } else {
+            logger->append("StoreWatcher", "Error: can't parse journal, dropping it\n");
+        }
+    }
+}
+
+void StoreWatcher::start(QStringList roots) {
+
+#ifdef Q_OS_LINUX
+    inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd < 0) {
+        logger->append("StoreWatcher", "Error: inotify init: " + QString(strerror(errno)) + "\n");
+        return;
+    }
+
+    live = true;
+    foreach (QString root, roots) {
+        if (!QDir(root).exists()) continue;
+
+        if (!addWatch(root, false)) {
+            live = false;
+            break;
+        }
+        watchedRoots << root;
+    }
+
+    if (!live) {
+        logger->append("StoreWatcher", "Error: can't watch store, fallback to full checks\n");
+        close(inotifyFd);
+        inotifyFd = -1;
+        watches.clear();
+        watchedRoots.clear();
+        return;
+    }
+
+    notifier = new QSocketNotifier(inotifyFd, QSocketNotifier::Read, this);
+    connect(notifier, SIGNAL(activated(int)), this, SLOT(readEvents()));
+
+    logger->append("StoreWatcher", "Watching " + QString::number(watches.size())
+                   + " directories, generation " + QString::number(generation) + "\n");
+#else
+    Q_UNUSED(roots);
+    logger->append("StoreWatcher", "Store watcher is not supported on this platform\n");
+#endif
+}
+
+bool StoreWatcher::addWatch(QString dir, bool markFiles) {
+
+#ifdef Q_OS_LINUX
+    int wd = inotify_add_watch(inotifyFd, QFile::encodeName(dir).constData(), watchMask);
+    if (wd < 0) {
+        logger->append("StoreWatcher", "Error: can't watch " + dir + ": " + QString(strerror(errno)) + "\n");
+        return false;
+    }
+    watches.insert(wd, dir);
+
+    QDir d(dir);
+
+    // Files of created or moved in directory are unknown
+    if (markFiles) {
+        foreach (QString file, d.entryList(QDir::Files | QDir::Hidden)) {
+            markDirty(dir + "/" + file);
+        }
+    }
+
+    foreach (QString subdir, d.entryList(QDir::Dirs | QDir::NoDotAndDotDot | QDir::NoSymLinks | QDir::Hidden)) {
+        if (!addWatch(dir + "/" + subdir, markFiles)) return false;
+    }
+
+    return true;
+#else
+    Q_UNUSED(dir);
+    Q_UNUSED(markFiles);
+    return false;
+#endif
+}
+
+void StoreWatcher::sync() {
+    readEvents();
+}
+
+void StoreWatcher::readEvents() {
+
+#ifdef Q_OS_LINUX
+    QMutexLocker eventsLocker(&eventsMutex);
+    if (inotifyFd < 0) return;
+
+    char buffer[16 * 1024] __attribute__((aligned(__alignof__(struct inotify_event))));
+
+    for (;;) {
+        ssize_t length = read(inotifyFd, buffer, sizeof(buffer));
+        if (length <= 0) break;
+
+        for (char* ptr = buffer; ptr < buffer + length; ) {
+            const struct inotify_event* event = (const struct inotify_event*) ptr;
+            ptr += sizeof(struct inotify_event) + event->len;
+
+            // Kernel queue overflowed, some changes are lost
+            if (event->mask & IN_Q_OVERFLOW) {
+                startRescan("event queue overflow", false);
+                continue;
+            }
+
+            QString dir = watches.value(event->wd);
+            if (dir.isEmpty()) continue;
+
+            // Watch removed (directory deleted or moved)
+            if (event->mask & IN_IGNORED) {
+                watches.remove(event->wd);
+                if (watchedRoots.contains(dir)) {
+                    QMutexLocker locker(&mutex);
+                    watchedRoots.removeAll(dir);
+                }
+                continue;
+            }
+
+            // Moved directory keeps the watch, but its path is not known anymore
+            if (event->mask & IN_MOVE_SELF) {
+                inotify_rm_watch(inotifyFd, event->wd);
+            }
+
+            QString path = dir;
+            if (event->len > 0) path += "/" + QFile::decodeName(event->name);
+
+            if ((event->mask & IN_ISDIR) && (event->mask & (IN_CREATE | IN_MOVED_TO))) {
+                unmarkDirty(path);
+                if (!addWatch(path, true)) {
+                    startRescan("can't watch new directory", true);
+                }
+                continue;
+            }
+
+            // Only removal of directory makes its content unknown
+            if ((event->mask & IN_ISDIR) || event->len == 0) {
+                if (event->mask & (IN_DELETE | IN_MOVED_FROM | IN_DELETE_SELF | IN_MOVE_SELF)) {
+                    markDirty(path);
+                }
+                continue;
+            }
+
+            if (isLauncherCache(watchedRoots, dir, QFile::decodeName(event->name))) continue;
+
+            markDirty(path);
+        }
+    }
+#endif
+}
+
+void StoreWatcher::startRescan(QString reason, bool watchLost) {
+
+    logger->append("StoreWatcher", "Full rescan needed: " + reason + "\n");
+
+    {
+        QMutexLocker locker(&mutex);
+
+        // Drop trust to all verified files, they will be checked by size and mtime
+        generation++;
+
+        // Changes in unwatched directories can't be tracked anymore
+        if (watchLost) live = false;
+    }
+
+    emit rescanNeeded();
+}
+
+void StoreWatcher::markDirty(QString path) {
+    QMutexLocker locker(&mutex);
+    dirtyPaths.insert(path);
+    changes++;
+
+    foreach (QString root, watchedRoots) {
+        if (path == root || path.startsWith(root + "/")) rootChanges[root]++;
+    }
+}
+
+void StoreWatcher::unmarkDirty(QString path) {
+    QMutexLocker locker(&mutex);
+    dirtyPaths.remove(path);
+}
+
+void StoreWatcher::markClean(QString fileName) {
+
+    QStringList dirtyDirs;
+    {
+        QMutexLocker locker(&mutex);
+        dirtyPaths.remove(fileName);
+
+        QString path = fileName;
+        for (;;) {
+            int slash = path.lastIndexOf('/');
+            if (slash <= 0) break;
+            path.truncate(slash);
+            if (dirtyPaths.contains(path)) dirtyDirs << path;
+        }
+    }
+
+    // Content of removed or replaced directory is unknown, so its dirty mark is
+    // moved to each file inside, otherwise verified files are never cleaned
+    foreach (QString dir, dirtyDirs) {
+        QStringList files;
+        QDirIterator it(dir, QDir::Files | QDir::Hidden, QDirIterator::Subdirectories);
+        while (it.hasNext()) files << it.next();
+
+        QMutexLocker locker(&mutex);
+        dirtyPaths.remove(dir);
+        foreach (QString file, files) {
+            if (file != fileName) dirtyPaths.insert(file);
+        }
+    }
+}
+
+quint64 StoreWatcher::getGeneration() {
+    QMutexLocker locker(&mutex);
+    return generation;
+}
+
+quint64 StoreWatcher::getChanges() {
+    QMutexLocker locker(&mutex);
+    return changes;
+}
+
+quint64 StoreWatcher::getChanges(QString root) {
+    QMutexLocker locker(&mutex);
+    return rootChanges.value(root);
+}
+
+bool StoreWatcher::isLive() {
+    QMutexLocker locker(&mutex);
+    return live;
+}
+
+bool StoreWatcher::isWatched(QString fileName) {
+
+    QMutexLocker locker(&mutex);
+    if (!live) return false;
+
+    foreach (QString root, watchedRoots) {
+        if (fileName.startsWith(root + "/")) return true;
+    }
+
+    return false;
+}
+
+bool StoreWatcher::isDirty(QString fileName) {
+
+    QMutexLocker locker(&mutex);
+    if (dirtyPaths.isEmpty()) return false;
+
+    // File itself or one of parent directories (deleted or moved out)
+    QString path = fileName;
+    for (;;) {
+        if (dirtyPaths.contains(path)) return true;
+
+        int slash = path.lastIndexOf('/');
+        if (slash <= 0) break;
+        path.truncate(slash);
+    }
+
+    return false;
+}
+
+void StoreWatcher::save() {
+
+    QJsonArray dirty;
+    quint64 savedGeneration;
+    {
+        QMutexLocker locker(&mutex);
+        foreach (QString path, dirtyPaths) {
+            // Removed paths are not interesting anymore
+            if (QFileInfo(path).exists()) dirty.append(path);
+        }
+        savedGeneration = generation;
+    }
+
+    QJsonObject journal;
+    journal["generation"] = double(savedGeneration);
+    journal["checkpoint"] = double(QDateTime::currentMSecsSinceEpoch());
+    journal["dirty"] = dirty;
+
+    QSaveFile journalFile(journalFileName);
+    if (journalFile.open(QIODevice::WriteOnly)) {
+        journalFile.write(QJsonDocument(journal).toJson(QJsonDocument::Compact));
+        if (!journalFile.commit()) {
+            logger->append("StoreWatcher", "Error: save journal: " + journalFile.errorString() + "\n");
+        }
+    } else {
+        logger->append("StoreWatcher", "Error: save journal: " + journalFile.errorString() + "\n");
+    }
+}
@@ -0,0 +1,70 @@
+#ifndef STOREWATCHER_H
+#define STOREWATCHER_H
+
+#include <QtCore>
+
+#include "logger.h"
+
+// Tracks changes in game store directories (inotify on linux).
+// Paths touched since the last verification are kept in persistent journal,
+// unchanged files verified in current watcher generation can be trusted without I/O.
+class StoreWatcher : public QObject
+{
+    Q_OBJECT
+public:
+    static StoreWatcher* instance();
+
+private:
+    static StoreWatcher* myInstance;
+
+    explicit StoreWatcher(QObject *parent = 0);
+
+    StoreWatcher& operator=(StoreWatcher const&);
+    StoreWatcher(StoreWatcher const&);
+
+    Logger* logger;
+
+    QString journalFileName;
+    QMutex mutex;
+    QMutex eventsMutex; // Guards inotify descriptor and watches, events are read from any thread
+
+    bool live;
+    quint64 generation;
+    quint64 changes; // Count of change events in current session
+    QHash<QString, quint64> rootChanges; // Same per watched root
+    QSet<QString> dirtyPaths;
+    QStringList watchedRoots;
+
+    int inotifyFd;
+    QSocketNotifier* notifier;
+    QHash<int, QString> watches;
+
+    bool addWatch(QString dir, bool markFiles);
+    void markDirty(QString path);
+    void unmarkDirty(QString path);
+    void startRescan(QString reason, bool watchLost);
+
+public:
+    void start(QStringList roots);
+    void save();
+
+    quint64 getGeneration();
+    quint64 getChanges();
+    quint64 getChanges(QString root);
+    bool isLive();
+    bool isWatched(QString fileName);
+    bool isDirty(QString fileName);
+    void markClean(QString fileName);
+
+    // Reads pending events, so they are not missed while main loop is busy
+    void sync();
+
+signals:
+    void rescanNeeded();
+
+private slots:
+    void readEvents();
+
+};
+
+#endif // STOREWATCHER_H
@@ -4,7 +4,7 @@
 #
 #-------------------------------------------------
 
-QT       += core gui webkitwidgets
+QT       += core gui webkitwidgets concurrent
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
@@ -29,7 +29,27 @@ SOURCES += main.cpp \
     fetchdialog.cpp \
     checkoutdialog.cpp \
     exportdialog.cpp \
-    licensedialog.cpp
+    licensedialog.cpp \
+    fingerprintcache.cpp \
+    integrityscrubber.cpp \
+    storewatcher.cpp \
+    installplan.cpp \
+    filetree.cpp \
+    launchplan.cpp \
+    gamesession.cpp \
+    nativescache.cpp \
+    prewarmer.cpp \
+    cdsarchive.cpp \
+    launchhistory.cpp \
+    versionscatalog.cpp \
+    javaregistry.cpp \
+    jvmprofile.cpp \
+    resourcecontrols.cpp \
+    authsession.cpp \
+    indexcache.cpp \
+    gameindex.cpp \
+    mavencoordinate.cpp \
+    jsonwriter.cpp
 
 HEADERS += launcherwindow.h \
     skinuploaddialog.h \
@@ -46,7 +66,27 @@ HEADERS += launcherwindow.h \
     fetchdialog.h \
     checkoutdialog.h \
     exportdialog.h \
-    licensedialog.h
+    licensedialog.h \
+    fingerprintcache.h \
+    integrityscrubber.h \
+    storewatcher.h \
+    installplan.h \
+    filetree.h \
+    launchplan.h \
+    gamesession.h \
+    nativescache.h \
+    prewarmer.h \
+    cdsarchive.h \
+    launchhistory.h \
+    versionscatalog.h \
+    javaregistry.h \
+    jvmprofile.h \
+    resourcecontrols.h \
+    authsession.h \
+    indexcache.h \
+    gameindex.h \
+    mavencoordinate.h \
+    jsonwriter.h
 
 FORMS += launcherwindow.ui \
     skinuploaddialog.ui \
@@ -6,6 +6,12 @@
 #include "settings.h"
 #include "logger.h"
 #include "util.h"
+#include "fingerprintcache.h"
+#include "installplan.h"
+#include "filetree.h"
+#include "versionscatalog.h"
+#include "indexcache.h"
+#include "gameindex.h"
 
 UpdateDialog::UpdateDialog(QString displayMessage, QWidget *parent) :
     QDialog(parent),
@@ -40,6 +46,7 @@ UpdateDialog::UpdateDialog(QString displayMessage, QWidget *parent) :
     }
 }
 
+
 void UpdateDialog::clientChanged() {
 
     logger->append("UpdateDialog", "Selected client: " + settings->getClientStrId(settings->loadActiveClientId()) + "\n");
@@ -155,6 +162,7 @@ void UpdateDialog::doCheck() {
         ui->updateButton->setEnabled(true);
         return;
     }
+    VersionsCatalog::update(settings->getClientStrId(settings->loadActiveClientId()), clientVersion);
 
     if (!downloadNow(versionUrlPrefix + "data.json",
                              versionFilePrefix + "data.json")) {
@@ -164,10 +172,9 @@ void UpdateDialog::doCheck() {
         return;
     }
 
-    // Reading info from indexes
-    QJsonDocument versionJson, dataJson;
+    // Reading assets index name from version index
+    GameIndex::VersionIndex versionJson;
 
-    // Reading version index
     QFile* versionIndexfile = new QFile(versionFilePrefix + clientVersion +".json");
     if (!versionIndexfile->open(QIODevice::ReadOnly)) {
 
@@ -176,20 +183,23 @@ void UpdateDialog::doCheck() {
 
         ui->clientCombo->setEnabled(true);
         ui->updateButton->setEnabled(true);
+        delete versionIndexfile;
         return;
 
     } else {
 
-        QJsonParseError error;
-        versionJson = QJsonDocument::fromJson(versionIndexfile->readAll(), &error);
+        QString error;
+        versionJson = IndexCache::parseVersion(versionFilePrefix + clientVersion + ".json",
+                                               versionIndexfile->readAll(), &error);
 
-        if (error.error != QJsonParseError::NoError) {
+        if (!error.isEmpty()) {
 
             ui->log->appendPlainText("Проверка остановлена. Ошибка: не удалось разобрать" + clientVersion +".json");
             logger->append("UpdateDialog", "Error: can't parse " + clientVersion +".json\n");
 
             ui->clientCombo->setEnabled(true);
             ui->updateButton->setEnabled(true);
+            delete versionIndexfile;
             return;
 
         }
@@ -197,119 +207,43 @@ void UpdateDialog::doCheck() {
     }
     delete versionIndexfile;
 
-    // Reading data index
-    QFile* dataIndexfile = new QFile(versionFilePrefix + "data.json");
-    if (!dataIndexfile->open(QIODevice::ReadOnly)) {
+    QString assetsVersion = versionJson.assets;
 
-        ui->log->appendPlainText("Проверка остановлена. Ошибка: не удалось открыть data.json");
-        logger->append("UpdateDialog", "Error: can't open data.json\n");
+    if (!downloadNow(settings->getAssetsUrl() + "indexes/" + assetsVersion + ".json",
+                             settings->getAssetsDir() + "/indexes/" + assetsVersion + ".json")) {
 
         ui->clientCombo->setEnabled(true);
         ui->updateButton->setEnabled(true);
         return;
+    }
 
-    } else {
-
-        QJsonParseError error;
-        dataJson = QJsonDocument::fromJson(dataIndexfile->readAll(), &error);
-
-        if (error.error != QJsonParseError::NoError) {
+    // Resolve list of game files from indexes
+    InstallPlan plan;
+    if (!plan.resolve(settings->getClientStrId(settings->loadActiveClientId()), clientVersion)) {
 
-            ui->log->appendPlainText("Проверка остановлена. Ошибка: не удалось разобрать data.json");
-            logger->append("UpdateDialog", "Error: can't parse data.json\n");
+        ui->log->appendPlainText("Проверка остановлена. Ошибка: " + plan.getErrorString());
+        logger->append("UpdateDialog", "Error: " + plan.getErrorString() + "\n");
 
-            ui->clientCombo->setEnabled(true);
-            ui->updateButton->setEnabled(true);
-            return;
-
-        }
-        dataIndexfile->close();
+        ui->clientCombo->setEnabled(true);
+        ui->updateButton->setEnabled(true);
+        return;
     }
-    delete dataIndexfile;
-
-    // Check game files
-    QString url, fileName, displayName, checkSum;
-    quint64 size;
 
     // Check main file
-    url = versionUrlPrefix + clientVersion + ".jar";
-    fileName = versionFilePrefix + clientVersion + ".jar";
-    displayName = "файл " + clientVersion + ".jar";
-    checkSum = dataJson.object()["main"].toObject()["hash"].toString();
-    size = dataJson.object()["main"].toObject()["size"].toInt();
-
-    if (addToQueryIfNeed(url, fileName, displayName, checkSum, size)) needUpdate = true;
+    foreach (InstallPlan::Artifact mainJar, plan.getArtifacts(InstallPlan::MainJar)) {
+        if (addToQueryIfNeed(mainJar.url, mainJar.path, "файл " + mainJar.name, mainJar.hash, mainJar.size)) {
+            needUpdate = true;
+        }
+    }
 
     // Check libs
     ui->log->appendPlainText("\n # Проверка библиотек:");
     logger->append("UpdateDialog", "Checking libs\n");
 
-    QString libFilePrefix = settings->getLibsDir() + "/";
-    QString libUrlPrefix = settings->getLibsUrl();
-
-    QJsonArray libraries = versionJson.object()["libraries"].toArray();
-    foreach (QJsonValue libValue, libraries) {
-        QJsonObject library = libValue.toObject();
-        QStringList entry = library["name"].toString().split(':');
-
-        // <package>:<name>:<version> to <package>/<name>/<version>/<name>-<version> and chahge <backage> format from a.b.c to a/b/c
-        QString libSuffix = entry.at(0);                // package
-        libSuffix.replace('.', '/');                    // package format
-        libSuffix += "/" + entry.at(1)                  // + name
-                + "/" + entry.at(2)                      // + version
-                + "/" + entry.at(1) + "-" + entry.at(2); // + name-version
-
-        // Check rules for disallow rules
-        QJsonArray rules = library["rules"].toArray();
-        bool allowLib = true;
-        if (!rules.isEmpty()) {
-
-            // Disallow libray if not in allow list
-            allowLib = false;
-
-            foreach (QJsonValue ruleValue, rules) {
-                QJsonObject rule = ruleValue.toObject();
-
-                // Process allow variants (all or specified)
-                if (rule["action"].toString() == "allow") {
-                    if (rule["os"].toObject().isEmpty()) {
-                        allowLib = true;
-                    } else if (rule["os"].toObject()["name"].toString() == settings->getOsName()) {
-                        allowLib = true;
-                    }
-                }
-
-                // Make exclusions from allow-list
-                if (rule["action"].toString() == "disallow") {
-                    if (rule["os"].toObject()["name"].toString() == settings->getOsName()) {
-                        allowLib = false;
-                    }
-                }
-            }
-        }
-        // Go to next lib entry, if this are disallowed
-        if (!allowLib) {
-            logger->append("UpdateDialog", "Skipping lib: " + libSuffix + ".jar\n");
-            continue;
+    foreach (InstallPlan::Artifact lib, plan.getArtifacts(InstallPlan::Library)) {
+        if (addToQueryIfNeed(lib.url, lib.path, "файл " + lib.name.split('/').last(), lib.hash, lib.size)) {
+            needUpdate = true;
         }
-
-        // Check for natives entry: <package>/<name>-<version>-<native_string>
-        QString nativesSuffix = library["natives"].toObject()[settings->getOsName()].toString();
-        nativesSuffix.replace("${arch}", settings->getWordSize());
-        if (!nativesSuffix.isEmpty()) {
-            libSuffix += "-" + nativesSuffix + ".jar";
-        } else {
-            libSuffix += ".jar";
-        }
-
-        // Check each library file by exists and hash
-        url = libUrlPrefix + libSuffix;
-        fileName = libFilePrefix + libSuffix;
-        displayName = "файл " + libSuffix.split('/').last();
-        checkSum = dataJson.object()["libs"].toObject()[libSuffix].toObject()["hash"].toString();
-        size = dataJson.object()["libs"].toObject()[libSuffix].toObject()["size"].toInt();
-
-        if (addToQueryIfNeed(url, fileName, displayName, checkSum, size)) needUpdate = true;
         QApplication::processEvents(); // Update text in log
     }
 
@@ -317,80 +251,33 @@ void UpdateDialog::doCheck() {
     ui->log->appendPlainText("\n # Проверка игровых ресурсов:");
     logger->append("UpdateDialog", "Checking assets\n");
 
-    QJsonDocument assetsJson;
-    QString assetsVersion = versionJson.object()["assets"].toString();
-    QString assetsFilePrefix = settings->getAssetsDir() + "/objects/";
-    QString assetsUrlPrefix = settings->getAssetsUrl() + "objects/";
-
-    if (!downloadNow(settings->getAssetsUrl() + "indexes/" + assetsVersion + ".json",
-                             settings->getAssetsDir() + "/indexes/" + assetsVersion + ".json")) {
-
-        dm->reset();
-        ui->clientCombo->setEnabled(true);
-        ui->updateButton->setEnabled(true);
-        return;
-    }
-
-    // Reading assets index
-    QFile* assetsIndexfile = new QFile(settings->getAssetsDir() + "/indexes/" + assetsVersion + ".json");
-    if (!assetsIndexfile->open(QIODevice::ReadOnly)) {
-
-        ui->log->appendPlainText("Проверка остановлена. Ошибка: не удалось открыть " + assetsVersion +".json");
-        logger->append("UpdateDialog", "Error: can't open assets index " + assetsVersion +".json\n");
-        return;
-
-    } else {
-
-        QJsonParseError error;
-        assetsJson = QJsonDocument::fromJson(assetsIndexfile->readAll(), &error);
-
-        if (error.error != QJsonParseError::NoError) {
-
-            ui->log->appendPlainText("Проверка остановлена. Ошибка: не удалось разобрать " + assetsVersion +".json");
-            logger->append("UpdateDialog", "Error: can't parse assets index " + assetsVersion +".json\n");
-
-            dm->reset();
-            ui->clientCombo->setEnabled(true);
-            ui->updateButton->setEnabled(true);
-            return;
-
+    foreach (InstallPlan::Artifact asset, plan.getArtifacts(InstallPlan::Asset)) {
+        if (addToQueryIfNeed(asset.url, asset.path, "ресурс " + asset.name, asset.hash, asset.size)) {
+            needUpdate = true;
         }
-        assetsIndexfile->close();
-    }
-    delete assetsIndexfile;
-
-    // Check each asset by exists and hash
-    QJsonObject assets = assetsJson.object()["objects"].toObject();
-
-    foreach (QString key, assets.keys()) {
-        QJsonObject asset = assets[key].toObject();
-
-        // Check each asset file
-        checkSum = asset["hash"].toString();
-        size = asset["size"].toInt();
-        url = assetsUrlPrefix + checkSum.mid(0, 2) + "/" + checkSum;
-        fileName = assetsFilePrefix + checkSum.mid(0, 2) + "/" + checkSum;
-        displayName = "ресурс " + key;
-
-        if (addToQueryIfNeed(url, fileName, displayName, checkSum, size)) needUpdate = true;
         QApplication::processEvents(); // Update text in log
     }
 
     // Check additional files if defined
-    if (!dataJson.object()["files"].toObject()["index"].isNull()) {
+    QList<InstallPlan::Artifact> customFiles = plan.getArtifacts(InstallPlan::CustomFile);
+    QString installedDataName = settings->getClientPrefix(clientVersion) + "/installed_data.json";
+
+    if (!customFiles.isEmpty() || QFile::exists(installedDataName)) {
 
         ui->log->appendPlainText("\n # Проверка дополнительных модификаций:");
         logger->append("UpdateDialog", "Checking custom files\n");
 
         // Open installed files index
-        QJsonDocument installedDataJson;
+        GameIndex::DataIndex installedIndex;
+        FileTree::Diff installedDiff;
+        bool installedIndexFound = false;
 
-        if (QFile::exists(settings->getClientPrefix(clientVersion) + "/installed_data.json")) {
+        if (QFile::exists(installedDataName)) {
 
             ui->log->appendPlainText("Проверка наличия устаревших файлов...");
             logger->append("UpdateDialog", "Making deletion list...\n");
 
-            QFile* installedDataFile = new QFile(settings->getClientPrefix(clientVersion) + "/installed_data.json");
+            QFile* installedDataFile = new QFile(installedDataName);
             if (!installedDataFile->open(QIODevice::ReadOnly)) {
 
                 ui->log->appendPlainText("Проверка остановлена. Ошибка: не удалось открыть installed_data.json");
@@ -399,14 +286,16 @@ void UpdateDialog::doCheck() {
                 dm->reset();
                 ui->clientCombo->setEnabled(true);
                 ui->updateButton->setEnabled(true);
+                delete installedDataFile;
                 return;
 
             } else {
 
-                QJsonParseError error;
-                installedDataJson = QJsonDocument::fromJson(installedDataFile->readAll(), &error);
+                QString error;
+                installedIndex = IndexCache::parseData(versionFilePrefix + "installed_data.json",
+                                                       installedDataFile->readAll(), &error);
 
-                if (error.error != QJsonParseError::NoError) {
+                if (!error.isEmpty()) {
 
                     ui->log->appendPlainText("Проверка остановлена. Ошибка: не удалось разобрать installed_data.json");
                     logger->append("UpdateDialog", "Error: can't parse installed_data.json\n");
@@ -414,6 +303,7 @@ void UpdateDialog::doCheck() {
                     dm->reset();
                     ui->clientCombo->setEnabled(true);
                     ui->updateButton->setEnabled(true);
+                    delete installedDataFile;
                     return;
 
                 }
@@ -421,51 +311,48 @@ void UpdateDialog::doCheck() {
             }
             delete installedDataFile;
 
-            // Check for difference between current and previous installations
-            QStringList currentFileList = dataJson.object()["files"].toObject()["index"].toObject().keys();
-            QStringList previousFileList = installedDataJson.object()["files"].toObject()["index"].toObject().keys();
+            // Check for difference between current and previous installations,
+            // directory digests let skip unchanged subtrees
+            GameIndex::DataIndex currentIndex = IndexCache::readData(versionFilePrefix + "data.json");
+
+            installedDiff = FileTree::compare(installedIndex.files, installedIndex.filesTree,
+                                              currentIndex.files, currentIndex.filesTree);
+            installedIndexFound = true;
+
+            logger->append("UpdateDialog", "Added since installation: " + QString::number(installedDiff.added.size())
+                           + ", changed: " + QString::number(installedDiff.changed.size())
+                           + ", removed: " + QString::number(installedDiff.removed.size())
+                           + ", unchanged subtrees: " + QString::number(installedDiff.unchangedDirs.size()) + "\n");
 
             // Add file to deletion list if exist in previous installation and not exists in current
-            foreach (QString installedEntry, previousFileList) {
-                if (currentFileList.indexOf(installedEntry) == -1) {
+            QStringList removedList = installedDiff.removed.toList();
+            removedList.sort();
+            foreach (QString installedEntry, removedList) {
 
-                    removeList.append(installedEntry);
-                    needUpdate = true;
+                removeList.append(installedEntry);
+                needUpdate = true;
 
-                    ui->log->appendPlainText(" >> Необходимо удалить: " + installedEntry);
-                    logger->append("UpdateDialog", "Marked to delete: " + installedEntry + "\n");
-                }
+                ui->log->appendPlainText(" >> Необходимо удалить: " + installedEntry);
+                logger->append("UpdateDialog", "Marked to delete: " + installedEntry + "\n");
             }
         }
 
-        // Check custom files
+        // Check custom files (mutable files checks only by existence)
         ui->log->appendPlainText("Проверка файлов модификаций...");
         logger->append("UpdateDialog", "Checking needed custom files...\n");
 
-        // Make mutable files list (that checks only by existence)
-        QStringList mutableList;
-        foreach (QJsonValue value, dataJson.object()["files"].toObject()["mutables"].toArray()) {
-            mutableList.append(value.toString());
-        }
-
-        QString filesFilePrefix = settings->getClientPrefix(clientVersion) + "/";
-        QString filesUrlPrefix = settings->getVersionUrl(clientVersion) + "files/";
-
-        foreach (QString key, dataJson.object()["files"].toObject()["index"].toObject().keys()) {
-
-            QJsonObject customFile
-                    = dataJson.object()["files"].toObject()["index"].toObject()[key].toObject();
+        foreach (InstallPlan::Artifact customFile, customFiles) {
 
-            // Check each custom file
-            checkSum = customFile["hash"].toString();
-            size = customFile["size"].toInt();
-            url = filesUrlPrefix + key;
-            fileName = filesFilePrefix + key;
-            displayName = "файл " + key;
-
-            if (mutableList.contains(key)) checkSum = "mutable"; // Download only if not exists
+            // Unchanged since installation and not touched after last verification
+            if (installedIndexFound && installedDiff.isUnchanged(customFile.name)
+                    && FingerprintCache::instance()->getFreshHash(customFile.path) == customFile.hash) {
+                continue;
+            }
 
-            if (addToQueryIfNeed(url, fileName, displayName, checkSum, size)) needUpdate = true;
+            if (addToQueryIfNeed(customFile.url, customFile.path, "файл " + customFile.name,
+                                 customFile.hash, customFile.size)) {
+                needUpdate = true;
+            }
             QApplication::processEvents(); // Update text in log
         }
     }
@@ -518,12 +405,13 @@ void UpdateDialog::doUpdate() {
         ui->log->appendPlainText("\n # Удаление устаревших модификаций:");
         logger->append("UpdateDialog", "Removing files...\n");
 
+        int removed = 0;
         foreach (QString entry, removeList) {
             ui->log->appendPlainText("Удаление: " + entry);
             logger->append("UpdateDialog", "Remove " + entry +"\n");
 
             QFile::remove(settings->getClientPrefix(clientVersion) + "/" + entry);
-            ui->progressBar->setValue(int((float(removeList.indexOf(entry) + 1) / removeList.size()) * 100));
+            ui->progressBar->setValue(int((float(++removed) / removeList.size()) * 100));
         }
 
     }
@@ -629,6 +517,9 @@ bool UpdateDialog::addToQueryIfNeed(QString url, QString fileName, QString displ
             file->close();
             delete file;
 
+            // Share result with launch-time verification
+            FingerprintCache::instance()->record(fileName, fileHash);
+
             if (fileHash != checkSum) {
 
                 logger->append("UpdateDialog", "Checking: bad checksum\n");
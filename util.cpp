@@ -160,44 +160,87 @@ void Util::recursiveFlist(QStringList *list, QString prefix, QString dpath) {
 }
 
 
-void Util::unzipArchive(QString zipFilePath, QString extractionPath) {
+bool Util::unzipArchive(QString zipFilePath, QString extractionPath, QStringList excludes, QString* errorString) {
 
     Logger* logger = Logger::logger();
     logger->append("Util", "Unzip archive " + zipFilePath + "\n");
 
+    QString error;
+    QString rootPath = QDir::cleanPath(extractionPath) + "/";
+
     QuaZip zip(zipFilePath);
-    if (zip.open(QuaZip::mdUnzip)) {
+    if (!zip.open(QuaZip::mdUnzip)) {
+        error = "can't open " + zipFilePath + ", error " + QString::number(zip.getZipError());
+
+    } else {
 
         QuaZipFile zipFile(&zip);
+        QByteArray buffer(64 * 1024, 0);
 
-        for (bool f=zip.goToFirstFile(); f; f=zip.goToNextFile()) {
-            zipFile.open(QIODevice::ReadOnly);
+        for (bool f = zip.goToFirstFile(); f && error.isEmpty(); f = zip.goToNextFile()) {
+            QString entryName = zip.getCurrentFileName();
 
-            QFile* realFile = new QFile(extractionPath + "/" + zip.getCurrentFileName());
+            bool excluded = false;
+            foreach (QString exclude, excludes) {
+                if (entryName.startsWith(exclude)) excluded = true;
+            }
+            if (excluded) continue;
 
-            QFileInfo rfInfo = QFileInfo(*realFile);
+            // Entries must not leave extraction path
+            QString realName = QDir::cleanPath(rootPath + entryName);
+            if (!realName.startsWith(rootPath)) {
+                error = "bad entry name " + entryName + " in " + zipFilePath;
+                break;
+            }
 
-            QDir rfDir = rfInfo.absoluteDir();
-            rfDir.mkpath(rfDir.absolutePath());
+            if (entryName.endsWith('/')) {
+                QDir().mkpath(realName);
+                continue;
+            }
+            QDir().mkpath(QFileInfo(realName).absolutePath());
 
-            if (!rfInfo.isDir()) {
+            if (!zipFile.open(QIODevice::ReadOnly)) {
+                error = "can't read " + entryName + " from " + zipFilePath;
+                break;
+            }
 
-                logger->append("Util", "Extracting file " + realFile->fileName() + "\n");
+            QFile realFile(realName);
+            if (!realFile.open(QIODevice::WriteOnly)) {
+                error = "can't write " + realName + ": " + realFile.errorString();
+                zipFile.close();
+                break;
+            }
 
-                if (realFile->open(QIODevice::WriteOnly)) {
-                    realFile->write(zipFile.readAll());
-                    realFile->close();
-                } else {
-                    logger->append("Util", "Unzip error: " + realFile->errorString() + "\n");
+            // Stream entry by fixed size chunks
+            qint64 read;
+            while ((read = zipFile.read(buffer.data(), buffer.size())) > 0) {
+                if (realFile.write(buffer.constData(), read) != read) {
+                    error = "can't write " + realName + ": " + realFile.errorString();
+                    break;
                 }
             }
+            if (read < 0 && error.isEmpty()) {
+                error = "can't read " + entryName + " from " + zipFilePath;
+            }
 
-            delete realFile;
+            realFile.close();
             zipFile.close();
+
+            // Checksum of entry is verified on close
+            if (error.isEmpty() && zipFile.getZipError() != UNZ_OK) {
+                error = "broken entry " + entryName + " in " + zipFilePath;
+            }
         }
         zip.close();
     }
 
+    if (!error.isEmpty()) {
+        logger->append("Util", "Unzip error: " + error + "\n");
+        if (errorString != 0) *errorString = error;
+        return false;
+    }
+
+    return true;
 }
 
 
@@ -18,7 +18,9 @@ QString getFileContetnts(QString path);
 bool downloadFile(QString url, QString fileName);
 void removeAll(QString filePath);
 void recursiveFlist(QStringList *list, QString prefix, QString dpath);
-void unzipArchive(QString zipFilePath, QString extractionPath);
+// Streams archive entries to extraction path, skipping entries that start with any of excludes
+bool unzipArchive(QString zipFilePath, QString extractionPath,
+                  QStringList excludes = QStringList(), QString* errorString = 0);
 
 }
 
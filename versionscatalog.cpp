@@ -0,0 +1,248 @@
+#include "versionscatalog.h"
+
+#include "settings.h"
+#include "logger.h"
+#include "indexcache.h"
+#include "gameindex.h"
+#include "storewatcher.h"
+
+#include <QCryptographicHash>
+#include <QSaveFile>
+
+// Catalog is updated from launcher and prewarmer threads
+static QMutex catalogMutex;
+
+// Watcher state at the moment of last reconciliation of client catalog
+struct Reconciliation {
+    quint64 generation;
+    quint64 changes;
+};
+static QHash<QString, Reconciliation> reconciled;
+
+static QString getCatalogFileName(QString client) {
+    return Settings::instance()->getVersionsDir(client) + "/catalog.json";
+}
+
+static QString getIndexFileName(QString client, QString version) {
+    return Settings::instance()->getVersionsDir(client) + "/" + version + "/" + version + ".json";
+}
+
+// Reads version index into catalog entry, returns false if index is missing or broken
+static bool readEntry(QString client, QString version, QJsonObject* entry) {
+
+    QFile indexFile(getIndexFileName(client, version));
+    if (!indexFile.open(QIODevice::ReadOnly)) return false;
+
+    QByteArray data = indexFile.readAll();
+    indexFile.close();
+
+    QString hash = QString(QCryptographicHash::hash(data, QCryptographicHash::Sha1).toHex());
+    if (entry->value("hash").toString() == hash && entry->contains("javaMajor")) return true;
+
+    QString error;
+    GameIndex::VersionIndex index = IndexCache::parseVersion(getIndexFileName(client, version), data, &error);
+    if (!error.isEmpty()) return false;
+
+    (*entry)["releaseTime"] = index.releaseTime;
+    (*entry)["type"] = index.type;
+    (*entry)["javaMajor"] = index.javaMajor;
+    (*entry)["hash"] = hash;
+    return true;
+}
+
+static QString selectLatest(const QJsonObject& versions) {
+
+    QString latest;
+    QDateTime latestTime;
+
+    for (QJsonObject::const_iterator it = versions.constBegin(); it != versions.constEnd(); ++it) {
+        QDateTime releaseTime = QDateTime::fromString(it.value().toObject()["releaseTime"].toString(), Qt::ISODate);
+        if (releaseTime.isValid() && (latestTime.isNull() || releaseTime > latestTime)) {
+            latestTime = releaseTime;
+            latest = it.key();
+        }
+    }
+
+    return latest;
+}
+
+static QJsonObject save(QString client, const QJsonObject& versions) {
+
+    QJsonObject catalog;
+    catalog["latest"] = selectLatest(versions);
+    catalog["versions"] = versions;
+
+    QSaveFile catalogFile(getCatalogFileName(client));
+    if (!catalogFile.open(QIODevice::WriteOnly)) {
+        Logger::logger()->append("VersionsCatalog", "Error: save catalog: " + catalogFile.errorString() + "\n");
+        return catalog;
+    }
+
+    catalogFile.write(QJsonDocument(catalog).toJson(QJsonDocument::Compact));
+    if (!catalogFile.commit()) {
+        Logger::logger()->append("VersionsCatalog", "Error: save catalog: " + catalogFile.errorString() + "\n");
+    }
+
+    return catalog;
+}
+
+// Scans all installed versions, used when there is no catalog yet
+static QJsonObject rebuild(QString client) {
+
+    Logger::logger()->append("VersionsCatalog", "Building versions catalog of " + client + "\n");
+
+    QJsonObject versions;
+    QDir versionsDir(Settings::instance()->getVersionsDir(client));
+
+    foreach (QString version, versionsDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+        QJsonObject entry;
+        if (readEntry(client, version, &entry)) versions[version] = entry;
+    }
+
+    return save(client, versions);
+}
+
+static QJsonObject load(QString client, bool* found) {
+
+    QFile catalogFile(getCatalogFileName(client));
+    if (!catalogFile.open(QIODevice::ReadOnly)) {
+        *found = false;
+        return QJsonObject();
+    }
+
+    QJsonParseError error;
+    QJsonObject catalog = QJsonDocument::fromJson(catalogFile.readAll(), &error).object();
+    catalogFile.close();
+
+    *found = (error.error == QJsonParseError::NoError);
+    return catalog;
+}
+
+static Reconciliation getWatcherState(QString client) {
+
+    StoreWatcher* watcher = StoreWatcher::instance();
+
+    Reconciliation state;
+    state.generation = watcher->getGeneration();
+    state.changes = watcher->getChanges(Settings::instance()->getVersionsDir(client));
+    return state;
+}
+
+// Versions directory is watched and not changed since last reconciliation
+// in this session (launcher caches there are not counted as changes)
+static bool isReconciled(QString client) {
+
+    StoreWatcher* watcher = StoreWatcher::instance();
+
+    // Events could be not read yet while main loop is busy
+    watcher->sync();
+    if (!reconciled.contains(client) || !watcher->isWatched(getCatalogFileName(client))) return false;
+
+    Reconciliation last = reconciled.value(client);
+    Reconciliation current = getWatcherState(client);
+    return last.generation == current.generation && last.changes == current.changes;
+}
+
+// Brings catalog in line with disk: versions with removed index are dropped,
+// versions copied in by hand are added. Costs a directory listing and
+// a stat per version, indexes are read only for new versions.
+static QJsonObject reconcile(QString client, const QJsonObject& catalog) {
+
+    QJsonObject versions = catalog.value("versions").toObject();
+    bool modified = false;
+
+    QStringList installed;
+    QDir versionsDir(Settings::instance()->getVersionsDir(client));
+    foreach (QString version, versionsDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+        if (QFile::exists(getIndexFileName(client, version))) installed << version;
+    }
+
+    foreach (QString version, versions.keys()) {
+        if (!installed.contains(version)) {
+            versions.remove(version);
+            modified = true;
+        }
+    }
+
+    foreach (QString version, installed) {
+        if (versions.contains(version)) continue;
+
+        QJsonObject entry;
+        if (readEntry(client, version, &entry)) {
+            versions[version] = entry;
+            modified = true;
+        }
+    }
+
+    // Catalog of older launcher has no stored latest version
+    if (modified || !catalog.contains("latest")) return save(client, versions);
+    return catalog;
+}
+
+// Loads catalog, reconciles it with disk only after changes in versions directory
+static QJsonObject loadCatalog(QString client) {
+
+    bool found;
+    QJsonObject catalog = load(client, &found);
+    if (found && isReconciled(client)) return catalog;
+
+    // Changes made while directory is listed are caught by the next load
+    Reconciliation state = getWatcherState(client);
+    catalog = found ? reconcile(client, catalog) : rebuild(client);
+    reconciled.insert(client, state);
+
+    return catalog;
+}
+
+namespace VersionsCatalog {
+
+void update(QString client, QString version) {
+
+    QMutexLocker locker(&catalogMutex);
+
+    QJsonObject versions = loadCatalog(client).value("versions").toObject();
+
+    QJsonObject entry = versions.value(version).toObject();
+
+    if (!readEntry(client, version, &entry)) {
+        if (!versions.contains(version)) return;
+        versions.remove(version);
+    } else {
+        // Index is not changed
+        if (versions.contains(version) && entry == versions.value(version).toObject()) return;
+        versions[version] = entry;
+    }
+
+    save(client, versions);
+}
+
+QString findLatest(QString client) {
+
+    QMutexLocker locker(&catalogMutex);
+    return loadCatalog(client).value("latest").toString();
+}
+
+QStringList getVersions(QString client) {
+
+    QMutexLocker locker(&catalogMutex);
+    return loadCatalog(client).value("versions").toObject().keys();
+}
+
+int getJavaMajor(QString client, QString version) {
+
+    QMutexLocker locker(&catalogMutex);
+
+    QJsonObject versions = loadCatalog(client).value("versions").toObject();
+    QJsonObject entry = versions.value(version).toObject();
+
+    // Not recorded yet or recorded by older launcher
+    if (!entry.contains("javaMajor")) {
+        if (!readEntry(client, version, &entry)) return 8;
+        versions[version] = entry;
+        save(client, versions);
+    }
+
+    return int(entry.value("javaMajor").toDouble(8));
+}
+
+}
@@ -0,0 +1,27 @@
+#ifndef VERSIONSCATALOG_H
+#define VERSIONSCATALOG_H
+
+#include <QtCore>
+
+// Installed versions of a client with release time, type, required Java and index hash,
+// kept in <client>/versions/catalog.json. Updated when a version index is
+// installed or refreshed, so version indexes are not parsed to list versions.
+// Version directories are listed to catch versions added or removed by hand only when
+// store watcher reports changes in versions directory (or it is not watched).
+namespace VersionsCatalog {
+
+// Records version index after it is downloaded or changed
+void update(QString client, QString version);
+
+// Returns installed version with the latest release time, or empty string
+QString findLatest(QString client);
+
+// Returns ids of installed versions
+QStringList getVersions(QString client);
+
+// Returns Java major version required by version index, 8 if not specified
+int getJavaMajor(QString client, QString version);
+
+}
+
+#endif // VERSIONSCATALOG_H